@@ -8,16 +8,62 @@
 /** @file animated_tile.cpp Everything related to animated tiles. */
 
 #include "stdafx.h"
-#include "core/alloc_func.hpp"
-#include "core/smallvec_type.hpp"
+#include "animated_tile_func.h"
+#include "date_func.h"
 #include "tile_cmd.h"
 #include "viewport_func.h"
 #include "framerate_type.h"
 
+#include <array>
+#include <unordered_map>
+
 #include "safeguards.h"
 
-/** The table/list with animated tiles. */
-std::vector<TileIndex> _animated_tiles;
+/** State of a tile in the animated tile registry. */
+struct AnimatedTile {
+	uint64 order;  ///< Position of the tile in the animation order; tiles added later come later.
+	uint64 wake;   ///< Tick at which a sleeping tile has to be animated again.
+	bool sleeping; ///< Whether the tile waits in the timing wheel instead of being animated every tick.
+};
+
+/** Reference to an animated tile in the lists below; it is stale when the registry has another state for the tile. */
+struct AnimatedTileRef {
+	uint64 order;   ///< Position of the tile in the animation order.
+	TileIndex tile; ///< The animated tile.
+
+	bool operator <(const AnimatedTileRef &other) const { return this->order < other.order; }
+};
+
+/** Reference to a sleeping tile in the timing wheel. */
+struct SleepingTileRef : AnimatedTileRef {
+	uint64 wake; ///< Tick at which the tile has to be animated again.
+};
+
+/** Hash of a tile index, for the registry of animated tiles. */
+struct TileIndexHash {
+	size_t operator()(TileIndex tile) const { return std::hash<uint32>{}(tile.value); }
+};
+
+/** Number of ticks covered by one turn of the timing wheel. */
+static const uint ANIMATION_WHEEL_SIZE = 256;
+
+/** The registry of all animated tiles. */
+static std::unordered_map<TileIndex, AnimatedTile, TileIndexHash> _animated_tiles;
+/** The animation order of the most recently added tile. */
+static uint64 _animated_tile_order;
+/** The tiles that are animated every tick, sorted on their animation order. */
+static std::vector<AnimatedTileRef> _awake_tiles;
+/** Sleeping tiles that were woken up, to be merged into #_awake_tiles at the next animation loop. */
+static std::vector<AnimatedTileRef> _woken_tiles;
+/** Sleeping tiles, in the slot of the tick they have to be animated again. Tiles sleeping for more than a turn stay in their slot. */
+static std::array<std::vector<SleepingTileRef>, ANIMATION_WHEEL_SIZE> _animation_wheel;
+/** Tick of the last animation loop, to know which slots of the timing wheel have passed. */
+static uint64 _animation_wheel_tick;
+
+/** Tile that is being animated at the moment, or #INVALID_TILE. */
+static TileIndex _animating_tile = INVALID_TILE;
+/** Tick at which the tile that is being animated has to be animated again. */
+static uint64 _animating_tile_wake;
 
 /**
  * Removes the given tile from the animated tile table.
@@ -25,46 +71,162 @@ std::vector<TileIndex> _animated_tiles;
  */
 void DeleteAnimatedTile(TileIndex tile)
 {
-	auto to_remove = std::find(_animated_tiles.begin(), _animated_tiles.end(), tile);
-	if (to_remove != _animated_tiles.end()) {
-		/* The order of the remaining elements must stay the same, otherwise the animation loop may miss a tile. */
-		_animated_tiles.erase(to_remove);
-		MarkTileDirtyByTile(tile);
-	}
+	/* References in the other lists become stale and are removed when they are encountered. */
+	if (_animated_tiles.erase(tile) != 0) MarkTileDirtyByTile(tile);
 }
 
 /**
  * Add the given tile to the animated tile table (if it does not exist
- * on that table yet). Also increases the size of the table if necessary.
+ * on that table yet). A sleeping tile is woken up, as whatever made its
+ * animation wait might have changed.
  * @param tile the tile to make animated
  */
 void AddAnimatedTile(TileIndex tile)
 {
 	MarkTileDirtyByTile(tile);
-	include(_animated_tiles, tile);
+
+	auto [it, inserted] = _animated_tiles.try_emplace(tile);
+	AnimatedTile &at = it->second;
+	if (inserted) {
+		at.order = ++_animated_tile_order;
+		at.wake = 0;
+		at.sleeping = false;
+		_awake_tiles.push_back({at.order, tile});
+	} else if (at.sleeping) {
+		at.sleeping = false;
+		_woken_tiles.push_back({at.order, tile});
+	}
+}
+
+/**
+ * Let the tile that is being animated skip the animation loops before the given tick.
+ * This may only be used when animating the tile on those ticks would not change
+ * anything, as the timing wheel is not saved: a client that joins a game has
+ * all tiles awake and animates them on every tick.
+ * @param tile The tile that is being animated.
+ * @param wake The tick at which the tile has to be animated again.
+ */
+void SetAnimatedTileWakeUp(TileIndex tile, uint64 wake)
+{
+	if (tile == _animating_tile) _animating_tile_wake = wake;
+}
+
+/**
+ * Move the sleeping tiles whose wake up tick has come from the timing wheel to the awake tiles.
+ * @param now The current tick.
+ */
+static void WakeAnimatedTiles(uint64 now)
+{
+	/* Visit the slots of all ticks since the previous animation loop, but every slot at most once. */
+	uint64 slots = 0;
+	if (now > _animation_wheel_tick) {
+		slots = std::min<uint64>(now - _animation_wheel_tick, ANIMATION_WHEEL_SIZE);
+	} else if (now < _animation_wheel_tick) {
+		slots = ANIMATION_WHEEL_SIZE;
+	}
+	_animation_wheel_tick = now;
+
+	for (uint64 i = 0; i < slots; i++) {
+		std::vector<SleepingTileRef> &slot = _animation_wheel[(now - i) % ANIMATION_WHEEL_SIZE];
+		slot.erase(std::remove_if(slot.begin(), slot.end(), [now](const SleepingTileRef &ref) {
+			auto it = _animated_tiles.find(ref.tile);
+			if (it == _animated_tiles.end()) return true;
+
+			AnimatedTile &at = it->second;
+			if (at.order != ref.order || !at.sleeping || at.wake != ref.wake) return true;
+			if (at.wake > now) return false;
+
+			at.sleeping = false;
+			_woken_tiles.push_back(ref);
+			return true;
+		}), slot.end());
+	}
+
+	if (_woken_tiles.empty()) return;
+
+	/* Keep the animation order; all awake tiles are animated in the order they were added. */
+	std::sort(_woken_tiles.begin(), _woken_tiles.end());
+	size_t awake = _awake_tiles.size();
+	_awake_tiles.insert(_awake_tiles.end(), _woken_tiles.begin(), _woken_tiles.end());
+	std::inplace_merge(_awake_tiles.begin(), _awake_tiles.begin() + awake, _awake_tiles.end());
+	_woken_tiles.clear();
 }
 
 /**
  * Animate all tiles in the animated tile list, i.e.\ call AnimateTile on them.
+ * Tiles are animated in the order they were added, which is the same for all
+ * clients of a network game. Sleeping tiles are skipped until their tick.
  */
 void AnimateAnimatedTiles()
 {
 	PerformanceAccumulator framerate(PFE_GL_LANDSCAPE);
 
-	const TileIndex *ti = _animated_tiles.data();
-	while (ti < _animated_tiles.data() + _animated_tiles.size()) {
-		const TileIndex curr = *ti;
-		AnimateTile(curr);
-		/* During the AnimateTile call, DeleteAnimatedTile could have been called,
-		 * deleting an element we've already processed and pushing the rest one
-		 * slot to the left. We can detect this by checking whether the index
-		 * in the current slot has changed - if it has, an element has been deleted,
-		 * and we should process the current slot again instead of going forward.
-		 * NOTE: this will still break if more than one animated tile is being
-		 *       deleted during the same AnimateTile call, but no code seems to
-		 *       be doing this anyway.
-		 */
-		if (*ti == curr) ++ti;
+	const uint64 now = _tick_counter;
+	WakeAnimatedTiles(now);
+
+	/* Tiles that are added during the loop are appended and animated in this loop as well.
+	 * The tiles that remain awake are compacted to the front of the list on the fly. */
+	size_t kept = 0;
+	for (size_t i = 0; i < _awake_tiles.size(); i++) {
+		const AnimatedTileRef ref = _awake_tiles[i];
+
+		auto it = _animated_tiles.find(ref.tile);
+		if (it == _animated_tiles.end() || it->second.order != ref.order || it->second.sleeping) continue;
+
+		_animating_tile = ref.tile;
+		_animating_tile_wake = 0;
+		AnimateTile(ref.tile);
+		_animating_tile = INVALID_TILE;
+
+		if (_animating_tile_wake > now) {
+			/* The tile might have been removed or replaced during its animation. */
+			it = _animated_tiles.find(ref.tile);
+			if (it == _animated_tiles.end() || it->second.order != ref.order) continue;
+
+			it->second.sleeping = true;
+			it->second.wake = _animating_tile_wake;
+			_animation_wheel[_animating_tile_wake % ANIMATION_WHEEL_SIZE].push_back({ref, _animating_tile_wake});
+			continue;
+		}
+
+		_awake_tiles[kept++] = ref;
+	}
+	_awake_tiles.resize(kept);
+}
+
+/**
+ * Get all animated tiles in their animation order, e.g.\ for saving them.
+ * @return The animated tiles.
+ */
+std::vector<TileIndex> GetAnimatedTiles()
+{
+	std::vector<AnimatedTileRef> refs;
+	refs.reserve(_animated_tiles.size());
+	for (const auto &[tile, at] : _animated_tiles) refs.push_back({at.order, tile});
+	std::sort(refs.begin(), refs.end());
+
+	std::vector<TileIndex> tiles;
+	tiles.reserve(refs.size());
+	for (const AnimatedTileRef &ref : refs) tiles.push_back(ref.tile);
+	return tiles;
+}
+
+/**
+ * Replace the animated tiles, e.g.\ after loading them. All tiles start awake.
+ * @param tiles The animated tiles in their animation order; duplicates are ignored.
+ */
+void SetAnimatedTiles(const std::vector<TileIndex> &tiles)
+{
+	InitializeAnimatedTiles();
+
+	for (TileIndex tile : tiles) {
+		auto [it, inserted] = _animated_tiles.try_emplace(tile);
+		if (!inserted) continue;
+
+		it->second.order = ++_animated_tile_order;
+		it->second.wake = 0;
+		it->second.sleeping = false;
+		_awake_tiles.push_back({it->second.order, tile});
 	}
 }
 
@@ -74,4 +236,9 @@ void AnimateAnimatedTiles()
 void InitializeAnimatedTiles()
 {
 	_animated_tiles.clear();
+	_animated_tile_order = 0;
+	_awake_tiles.clear();
+	_woken_tiles.clear();
+	for (auto &slot : _animation_wheel) slot.clear();
+	_animation_wheel_tick = 0;
 }
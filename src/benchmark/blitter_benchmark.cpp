@@ -0,0 +1,168 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file blitter_benchmark.cpp Draws the same sprite many times with every usable
+ *                             blitter and reports the drawing speed in Mpixels/s.
+ *
+ * Usage: blitter_benchmark [draws]
+ */
+
+#include "../stdafx.h"
+#include "../blitter/factory.hpp"
+#include "../gfx_func.h"
+#include "../settings_type.h"
+#include "../spritecache.h"
+#include "../core/random_func.hpp"
+
+#include <chrono>
+#include <cstdarg>
+
+#include "../safeguards.h"
+
+/* The blitters only need a few bits of the game, so those are provided here. */
+ClientSettings _settings_client;
+Palette _cur_palette;
+DrawPixelInfo _screen;
+/* static */ thread_local ReusableBuffer<SpriteLoader::CommonPixel> SpriteLoader::Sprite::buffer[ZOOM_LVL_COUNT];
+int _debug_driver_level = 0;
+std::string _ini_blitter;
+bool _blitter_autodetected;
+
+void DebugPrint(const char *level, const std::string &message)
+{
+	fprintf(stderr, "dbg: [%s] %s\n", level, message.c_str());
+}
+
+void NORETURN CDECL error(const char *s, ...)
+{
+	va_list va;
+	va_start(va, s);
+	vfprintf(stderr, s, va);
+	va_end(va);
+	abort();
+}
+
+void *GetRawSprite(SpriteID sprite, SpriteType type, AllocatorProc *allocator, SpriteEncoder *encoder)
+{
+	NOT_REACHED();
+}
+
+static const uint SPRITE_WIDTH = 64;   ///< Width of the benchmarked sprite, about that of a building.
+static const uint SPRITE_HEIGHT = 64;  ///< Height of the benchmarked sprite.
+static const int SCREEN_WIDTH = 1024;  ///< Width of the buffer that is drawn to.
+static const int SCREEN_HEIGHT = 768;  ///< Height of the buffer that is drawn to.
+
+/** Blitters that can draw without a video driver; the animated ones need the screen's animation buffer. */
+static const char * const _blitters[] = {
+	"8bpp-simple", "8bpp-optimized",
+	"32bpp-simple", "32bpp-optimized", "32bpp-sse2", "32bpp-ssse3", "32bpp-sse4", "32bpp-avx2",
+};
+
+/** Modes worth measuring; crash and black remap are rare and share the per-pixel loops. */
+static const std::pair<BlitterMode, const char *> _modes[] = {
+	{ BM_NORMAL,       "normal" },
+	{ BM_COLOUR_REMAP, "remap" },
+	{ BM_TRANSPARENT,  "transparent" },
+};
+
+/** Allocator for the encoded sprites, which are never freed. */
+static void *AllocateSprite(size_t size)
+{
+	return MallocT<byte>(size);
+}
+
+/**
+ * Make a sprite with a mix of transparent, translucent, opaque and remapped pixels.
+ * @param sprite Sprite to fill; only the normal zoom level is used.
+ * @param rgb Whether to fill in the RGB channels or only the palette index.
+ */
+static void MakeSprite(SpriteLoader::Sprite *sprite, bool rgb)
+{
+	sprite->width = SPRITE_WIDTH;
+	sprite->height = SPRITE_HEIGHT;
+	sprite->x_offs = 0;
+	sprite->y_offs = 0;
+	/* Font sprites are encoded for the normal zoom level only, so no zoomed out copies are needed. */
+	sprite->type = ST_FONT;
+	sprite->colours = rgb ? (SCC_RGB | SCC_ALPHA | SCC_PAL) : SCC_PAL;
+	sprite->AllocateData(ZOOM_LVL_NORMAL, SPRITE_WIDTH * SPRITE_HEIGHT);
+
+	SetRandomSeed(0);
+	for (uint i = 0; i < SPRITE_WIDTH * SPRITE_HEIGHT; i++) {
+		SpriteLoader::CommonPixel &px = sprite->data[i];
+		uint r = Random();
+		/* About a quarter of a typical sprite is transparent, mostly in runs. */
+		if ((i % SPRITE_WIDTH) < SPRITE_WIDTH / 8 || (i % SPRITE_WIDTH) >= SPRITE_WIDTH * 7 / 8 || GB(r, 0, 4) == 0) continue;
+		if (rgb) {
+			px.r = GB(r, 4, 8);
+			px.g = GB(r, 12, 8);
+			px.b = GB(r, 20, 8);
+			px.a = GB(r, 28, 2) == 0 ? 128 : 255;
+			/* Some pixels take the company colour. */
+			if (GB(r, 30, 2) == 0) px.m = 0xC6 + GB(r, 4, 3);
+		} else {
+			px.m = 1 + GB(r, 4, 8) % 255;
+			px.a = 255;
+		}
+	}
+}
+
+int CDECL main(int argc, char *argv[])
+{
+	uint draws = argc > 1 ? atoi(argv[1]) : 20000;
+
+	for (uint i = 0; i < 256; i++) _cur_palette.palette[i] = Colour(i, i, i);
+	byte remap[256];
+	for (uint i = 0; i < 256; i++) remap[i] = (i + 16) & 0xFF;
+
+	SpriteLoader::Sprite loaded[ZOOM_LVL_COUNT];
+
+	printf("%-18s %12s %12s %12s  (Mpixels/s, %u draws of %ux%u)\n", "blitter", "normal", "remap", "transparent", draws, SPRITE_WIDTH, SPRITE_HEIGHT);
+	for (const char *name : _blitters) {
+		BlitterFactory *factory = BlitterFactory::GetBlitterFactory(name);
+		if (factory == nullptr) {
+			printf("%-18s not usable on this machine\n", name);
+			continue;
+		}
+		Blitter *blitter = factory->CreateInstance();
+		MakeSprite(&loaded[ZOOM_LVL_NORMAL], blitter->Is32BppSupported());
+		const Sprite *sprite = blitter->Encode(loaded, AllocateSprite);
+
+		std::vector<byte> screen(blitter->BufferSize(SCREEN_WIDTH, SCREEN_HEIGHT));
+
+		printf("%-18s", name);
+		for (const auto &mode : _modes) {
+			Blitter::BlitterParams bp;
+			bp.sprite = sprite->data;
+			bp.remap = remap;
+			bp.skip_left = 0;
+			bp.skip_top = 0;
+			bp.width = sprite->width;
+			bp.height = sprite->height;
+			bp.sprite_width = sprite->width;
+			bp.sprite_height = sprite->height;
+			bp.dst = screen.data();
+			bp.pitch = SCREEN_WIDTH;
+
+			auto start = std::chrono::steady_clock::now();
+			for (uint i = 0; i < draws; i++) {
+				/* Walk over the screen with odd steps so the sprite is not always aligned the same way. */
+				bp.left = (i * 37) % (SCREEN_WIDTH - SPRITE_WIDTH);
+				bp.top = (i * 23) % (SCREEN_HEIGHT - SPRITE_HEIGHT);
+				blitter->Draw(&bp, mode.first, ZOOM_LVL_NORMAL);
+			}
+			std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+			printf(" %12.1f", (double)draws * SPRITE_WIDTH * SPRITE_HEIGHT / seconds.count() / 1e6);
+		}
+		printf("\n");
+
+		free(const_cast<Sprite *>(sprite));
+		delete blitter;
+	}
+	return 0;
+}
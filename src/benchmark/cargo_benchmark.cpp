@@ -0,0 +1,133 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file cargo_benchmark.cpp Loads and unloads a large station for a number of ticks
+ *                           and reports how long the cargo list operations took.
+ *
+ * Usage: cargo_benchmark [ticks] [packets]
+ */
+
+#include "../stdafx.h"
+#include "../cargopacket.h"
+#include "../economy_base.h"
+#include "../station_base.h"
+#include "../core/random_func.hpp"
+
+#include <chrono>
+#include <cstdarg>
+
+#include "../safeguards.h"
+
+/* The benchmark never delivers, transfers or reroutes cargo, so the parts of
+ * the game these would call into are not linked in. */
+
+Money CargoPayment::PayTransfer(const CargoPacket *cp, uint count)
+{
+	NOT_REACHED();
+}
+
+void CargoPayment::PayFinalDelivery(const CargoPacket *cp, uint count)
+{
+	NOT_REACHED();
+}
+
+void FlowStat::ChangeShare(StationID st, int flow)
+{
+	NOT_REACHED();
+}
+
+StationID FlowStat::GetVia(StationID excluded, StationID excluded2) const
+{
+	NOT_REACHED();
+}
+
+void NORETURN SlErrorCorruptFmt(const char *format, ...)
+{
+	va_list va;
+	va_start(va, format);
+	vfprintf(stderr, format, va);
+	va_end(va);
+	abort();
+}
+
+void NORETURN CDECL error(const char *s, ...)
+{
+	va_list va;
+	va_start(va, s);
+	vfprintf(stderr, s, va);
+	va_end(va);
+	abort();
+}
+
+static const uint NUM_NEXT_HOPS = 8; ///< Number of stations the cargo at the benchmarked station is headed for.
+static const uint NUM_VEHICLES = 16; ///< Number of vehicles loading at the station every tick.
+static const uint VEHICLE_CAPACITY = 200; ///< Amount of cargo a single vehicle loads per tick.
+
+/**
+ * Append a packet with some variation in its source, so packets are not merged away.
+ * @param list List to append to.
+ */
+static void AppendPacket(StationCargoList &list)
+{
+	uint r = InteractiveRandom();
+	CargoPacket *cp = new CargoPacket(GB(r, 0, 8), TileIndex(GB(r, 8, 12)), 1 + GB(r, 20, 5), ST_INDUSTRY, GB(r, 0, 8));
+	list.Append(cp, GB(r, 25, 3) % NUM_NEXT_HOPS);
+}
+
+int CDECL main(int argc, char *argv[])
+{
+	uint ticks = argc > 1 ? atoi(argv[1]) : 500;
+	uint packets = argc > 2 ? atoi(argv[2]) : 10000;
+
+	SetRandomSeed(0);
+	/* The lists rely on their owners being zeroed by the pool allocator; static storage does the same. */
+	static StationCargoList station;
+	static VehicleCargoList vehicles[NUM_VEHICLES];
+	for (uint i = 0; i < packets; i++) AppendPacket(station);
+	const uint target = station.AvailableCount();
+
+	using clock = std::chrono::steady_clock;
+	clock::duration append_time{}, load_time{}, truncate_time{};
+	uint64 moved = 0;
+
+	for (uint tick = 0; tick < ticks; tick++) {
+		/* Keep the amount of waiting cargo roughly the same. */
+		clock::time_point start = clock::now();
+		while (station.AvailableCount() < target) AppendPacket(station);
+		clock::time_point loading = clock::now();
+		append_time += loading - start;
+
+		for (uint i = 0; i < NUM_VEHICLES; i++) {
+			VehicleCargoList &v = vehicles[i];
+			StationID hop = (tick + i) % NUM_NEXT_HOPS;
+			StationIDStack next(hop);
+			/* Reserve, give some of it back and load the rest, as a vehicle leaving early would. */
+			moved += station.Reserve(VEHICLE_CAPACITY, &v, TileIndex(i), next);
+			moved += v.Return(VEHICLE_CAPACITY / 4, &station, hop);
+			moved += station.Load(VEHICLE_CAPACITY, &v, TileIndex(i), next);
+			/* The vehicle has left and unloaded somewhere else. */
+			moved += v.Truncate();
+		}
+		clock::time_point truncating = clock::now();
+		/* Bad ratings make some of the waiting cargo disappear. */
+		moved += station.Truncate(station.AvailableCount() / 64);
+		truncate_time += clock::now() - truncating;
+		load_time += truncating - loading;
+	}
+
+	auto ms = [](clock::duration d) { return std::chrono::duration_cast<std::chrono::microseconds>(d).count() / 1000.0; };
+	printf("%u ticks, %u cargo waiting at the end, %llu cargo moved\n", ticks, station.AvailableCount(), (unsigned long long)moved);
+	printf("append:      %10.3f ms (%.3f us/tick)\n", ms(append_time), ms(append_time) * 1000.0 / ticks);
+	printf("load/return: %10.3f ms (%.3f us/tick)\n", ms(load_time), ms(load_time) * 1000.0 / ticks);
+	printf("truncate:    %10.3f ms (%.3f us/tick)\n", ms(truncate_time), ms(truncate_time) * 1000.0 / ticks);
+
+	for (uint i = 0; i < NUM_VEHICLES; i++) vehicles[i].OnCleanPool();
+	station.OnCleanPool();
+	_cargopacket_pool.CleanPool();
+	return 0;
+}
@@ -0,0 +1,291 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file 32bpp_avx2.cpp Implementation of the AVX2 32 bpp blitter. */
+
+#ifdef WITH_SSE
+
+#include "../stdafx.h"
+#include "../zoom_func.h"
+#include "../gfx_func.h"
+#include "32bpp_avx2.hpp"
+
+#include "../table/sprites.h"
+
+#include <immintrin.h>
+
+#include "../safeguards.h"
+
+/** Instantiation of the AVX2 32bpp blitter factory. */
+static FBlitter_32bppAVX2 iFBlitter_32bppAVX2;
+
+/**
+ * Get a mask selecting the first pixels of a block of eight, for the masked loads and stores.
+ * @param count Number of pixels to select, less than eight.
+ * @return The mask.
+ */
+GNU_TARGET("avx2")
+static inline __m256i TailMask(uint count)
+{
+	return _mm256_cmpgt_epi32(_mm256_set1_epi32(count), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+
+/**
+ * Alpha blend four pixels, expanded to 16 bits per channel. This is the same
+ * calculation as the SSE blitters do, so the results are identical.
+ */
+GNU_TARGET("avx2")
+static inline __m256i AlphaBlendExpandedPixels(__m256i src, __m256i dst, const __m256i &distribution_mask)
+{
+	__m256i alpha = _mm256_cmpgt_epi16(src, _mm256_setzero_si256()); // if (alpha > 0) a++;
+	alpha = _mm256_srli_epi16(alpha, 15);
+	alpha = _mm256_add_epi16(alpha, src);
+	alpha = _mm256_shuffle_epi8(alpha, distribution_mask);
+
+	src = _mm256_sub_epi16(src, dst);    //    (r - Cr)
+	src = _mm256_mullo_epi16(src, alpha); //  a*(r - Cr)
+	src = _mm256_srli_epi16(src, 8);      //  a*(r - Cr)/256
+	src = _mm256_add_epi16(src, dst);     //  a*(r - Cr)/256 + Cr
+	return _mm256_and_si256(src, _mm256_set1_epi16(0x00FF));
+}
+
+/** Alpha blend eight pixels. */
+GNU_TARGET("avx2")
+static inline __m256i AlphaBlendEightPixels(__m256i src, __m256i dst, const __m256i &distribution_mask)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i lo = AlphaBlendExpandedPixels(_mm256_unpacklo_epi8(src, zero), _mm256_unpacklo_epi8(dst, zero), distribution_mask);
+	__m256i hi = AlphaBlendExpandedPixels(_mm256_unpackhi_epi8(src, zero), _mm256_unpackhi_epi8(dst, zero), distribution_mask);
+	return _mm256_packus_epi16(lo, hi);
+}
+
+/** Copy the non transparent pixels of eight pixels without translucency. */
+GNU_TARGET("avx2")
+static inline __m256i CopyEightOpaquePixels(__m256i src, __m256i dst)
+{
+	__m256i transparent = _mm256_cmpeq_epi32(_mm256_and_si256(src, _mm256_set1_epi32(0xFF000000)), _mm256_setzero_si256());
+	return _mm256_blendv_epi8(src, dst, transparent);
+}
+
+/**
+ * Darken eight pixels.
+ * rgb = rgb * ((256/4) * 4 - (alpha/4)) / ((256/4) * 4)
+ */
+GNU_TARGET("avx2")
+static inline __m256i DarkenEightPixels(__m256i src, __m256i dst, const __m256i &distribution_mask)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i nom_base = _mm256_set1_epi16(256);
+
+	__m256i alpha_lo = _mm256_srli_epi16(_mm256_shuffle_epi8(_mm256_unpacklo_epi8(src, zero), distribution_mask), 2);
+	__m256i alpha_hi = _mm256_srli_epi16(_mm256_shuffle_epi8(_mm256_unpackhi_epi8(src, zero), distribution_mask), 2);
+	__m256i lo = _mm256_mullo_epi16(_mm256_unpacklo_epi8(dst, zero), _mm256_sub_epi16(nom_base, alpha_lo));
+	__m256i hi = _mm256_mullo_epi16(_mm256_unpackhi_epi8(dst, zero), _mm256_sub_epi16(nom_base, alpha_hi));
+	return _mm256_packus_epi16(_mm256_srli_epi16(lo, 8), _mm256_srli_epi16(hi, 8));
+}
+
+/**
+ * Draws a sprite to a (screen) buffer. It is templated to allow faster operation.
+ *
+ * @tparam mode blitter mode
+ * @param bp further blitting parameters
+ * @param zoom zoom level at which we are drawing
+ */
+template <BlitterMode mode, Blitter_32bppSSE_Base::ReadMode read_mode, bool translucent>
+GNU_TARGET("avx2")
+inline void Blitter_32bppAVX2::Draw(const Blitter::BlitterParams *bp, ZoomLevel zoom)
+{
+	Colour *dst_line = (Colour *) bp->dst + bp->top * bp->pitch + bp->left;
+	int effective_width = bp->width;
+
+	/* Find where to start reading in the source sprite. */
+	const SpriteData * const sd = (const SpriteData *) bp->sprite;
+	const SpriteInfo * const si = &sd->infos[zoom];
+	const Colour *src_rgba_line = (const Colour *) ((const byte *) &sd->data[si->sprite_offset] + bp->skip_top * si->sprite_line_size);
+
+	if (read_mode != RM_WITH_MARGIN) {
+		src_rgba_line += bp->skip_left;
+	}
+
+	/* Load these variables into register before loop. */
+	const __m256i a_cm = _mm256_broadcastsi128_si256(ALPHA_CONTROL_MASK);
+
+	for (int y = bp->height; y != 0; y--) {
+		Colour *dst = dst_line;
+		const Colour *src = src_rgba_line + META_LENGTH;
+
+		if (read_mode == RM_WITH_MARGIN) {
+			src += src_rgba_line[0].data;
+			dst += src_rgba_line[0].data;
+			const int width_diff = si->sprite_width - bp->width;
+			effective_width = bp->width - (int) src_rgba_line[0].data;
+			const int delta_diff = (int) src_rgba_line[1].data - width_diff;
+			const int new_width = effective_width - delta_diff;
+			effective_width = delta_diff > 0 ? new_width : effective_width;
+			if (effective_width <= 0) goto next_line;
+		}
+
+		switch (mode) {
+			default: {
+				uint x = (uint) effective_width;
+				for (; x >= 8; x -= 8) {
+					__m256i srcABCD = _mm256_loadu_si256((const __m256i *) src);
+					__m256i dstABCD = _mm256_loadu_si256((const __m256i *) dst);
+					dstABCD = translucent ? AlphaBlendEightPixels(srcABCD, dstABCD, a_cm) : CopyEightOpaquePixels(srcABCD, dstABCD);
+					_mm256_storeu_si256((__m256i *) dst, dstABCD);
+					src += 8;
+					dst += 8;
+				}
+
+				if (x != 0) {
+					const __m256i tail = TailMask(x);
+					__m256i srcABCD = _mm256_maskload_epi32((const int *) src, tail);
+					__m256i dstABCD = _mm256_maskload_epi32((const int *) dst, tail);
+					dstABCD = translucent ? AlphaBlendEightPixels(srcABCD, dstABCD, a_cm) : CopyEightOpaquePixels(srcABCD, dstABCD);
+					_mm256_maskstore_epi32((int *) dst, tail, dstABCD);
+				}
+				break;
+			}
+
+			case BM_TRANSPARENT: {
+				/* Make the current colour a bit more black, so it looks like this image is transparent. */
+				uint x = (uint) bp->width;
+				for (; x >= 8; x -= 8) {
+					__m256i srcABCD = _mm256_loadu_si256((const __m256i *) src);
+					__m256i dstABCD = _mm256_loadu_si256((const __m256i *) dst);
+					_mm256_storeu_si256((__m256i *) dst, DarkenEightPixels(srcABCD, dstABCD, a_cm));
+					src += 8;
+					dst += 8;
+				}
+
+				if (x != 0) {
+					const __m256i tail = TailMask(x);
+					__m256i srcABCD = _mm256_maskload_epi32((const int *) src, tail);
+					__m256i dstABCD = _mm256_maskload_epi32((const int *) dst, tail);
+					_mm256_maskstore_epi32((int *) dst, tail, DarkenEightPixels(srcABCD, dstABCD, a_cm));
+				}
+				break;
+			}
+
+			case BM_BLACK_REMAP:
+				for (uint x = (uint) bp->width; x > 0; x--) {
+					if (src->a != 0) {
+						*dst = Colour(0, 0, 0);
+					}
+					dst++;
+					src++;
+				}
+				break;
+		}
+
+next_line:
+		src_rgba_line = (const Colour*) ((const byte*) src_rgba_line + si->sprite_line_size);
+		dst_line += bp->pitch;
+	}
+}
+
+/**
+ * Draws a sprite to a (screen) buffer. Calls adequate templated function.
+ *
+ * @param bp further blitting parameters
+ * @param mode blitter mode
+ * @param zoom zoom level at which we are drawing
+ */
+void Blitter_32bppAVX2::Draw(Blitter::BlitterParams *bp, BlitterMode mode, ZoomLevel zoom)
+{
+	switch (mode) {
+		default: {
+			if (bp->skip_left != 0 || bp->width <= MARGIN_NORMAL_THRESHOLD) {
+bm_normal:
+				Draw<BM_NORMAL, RM_WITH_SKIP, true>(bp, zoom);
+			} else {
+				if (((const Blitter_32bppSSE_Base::SpriteData *) bp->sprite)->flags & SF_TRANSLUCENT) {
+					Draw<BM_NORMAL, RM_WITH_MARGIN, true>(bp, zoom);
+				} else {
+					Draw<BM_NORMAL, RM_WITH_MARGIN, false>(bp, zoom);
+				}
+			}
+			return;
+		}
+		case BM_COLOUR_REMAP:
+			if (((const Blitter_32bppSSE_Base::SpriteData *) bp->sprite)->flags & SF_NO_REMAP) goto bm_normal;
+			/* The remap looks up the palette per pixel, which the SSE4 code does faster. */
+			Blitter_32bppSSE4::Draw(bp, mode, zoom);
+			return;
+		case BM_TRANSPARENT:  Draw<BM_TRANSPARENT, RM_NONE, true>(bp, zoom); return;
+		case BM_CRASH_REMAP:  Blitter_32bppSSE4::Draw(bp, mode, zoom); return;
+		case BM_BLACK_REMAP:  Draw<BM_BLACK_REMAP, RM_NONE, true>(bp, zoom); return;
+	}
+}
+
+/** Darken eight pixels like Blitter_32bppBase::MakeTransparent(colour, 154) does. */
+GNU_TARGET("avx2")
+static inline __m256i MakeEightPixelsTransparent(__m256i colour)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i nom = _mm256_set1_epi16(154);
+	__m256i lo = _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(colour, zero), nom), 8);
+	__m256i hi = _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(colour, zero), nom), 8);
+	return _mm256_or_si256(_mm256_packus_epi16(lo, hi), _mm256_set1_epi32(0xFF000000));
+}
+
+/** Make eight pixels grey like Blitter_32bppBase::MakeGrey() does. */
+GNU_TARGET("avx2")
+static inline __m256i MakeEightPixelsGrey(__m256i colour)
+{
+	const __m256i channel = _mm256_set1_epi32(0xFF);
+	__m256i b = _mm256_and_si256(colour, channel);
+	__m256i g = _mm256_and_si256(_mm256_srli_epi32(colour, 8), channel);
+	__m256i r = _mm256_and_si256(_mm256_srli_epi32(colour, 16), channel);
+
+	__m256i grey = _mm256_mullo_epi32(r, _mm256_set1_epi32(19595));
+	grey = _mm256_add_epi32(grey, _mm256_mullo_epi32(g, _mm256_set1_epi32(38470)));
+	grey = _mm256_add_epi32(grey, _mm256_mullo_epi32(b, _mm256_set1_epi32(7471)));
+	grey = _mm256_srli_epi32(grey, 16);
+
+	return _mm256_or_si256(_mm256_mullo_epi32(grey, _mm256_set1_epi32(0x010101)), _mm256_set1_epi32(0xFF000000));
+}
+
+/**
+ * Apply a colour mapping operation to a rectangle, eight pixels at a time.
+ * @tparam newspaper Whether to make the pixels grey, otherwise they are made transparent.
+ * @param dst Top left pixel of the rectangle.
+ * @param width Width of the rectangle.
+ * @param height Height of the rectangle.
+ */
+template <bool newspaper>
+GNU_TARGET("avx2")
+static void DrawColourMappingRectAVX2(Colour *dst, int width, int height)
+{
+	do {
+		Colour *udst = dst;
+		uint x = (uint) width;
+		for (; x >= 8; x -= 8) {
+			__m256i colour = _mm256_loadu_si256((const __m256i *) udst);
+			_mm256_storeu_si256((__m256i *) udst, newspaper ? MakeEightPixelsGrey(colour) : MakeEightPixelsTransparent(colour));
+			udst += 8;
+		}
+
+		if (x != 0) {
+			const __m256i tail = TailMask(x);
+			__m256i colour = _mm256_maskload_epi32((const int *) udst, tail);
+			_mm256_maskstore_epi32((int *) udst, tail, newspaper ? MakeEightPixelsGrey(colour) : MakeEightPixelsTransparent(colour));
+		}
+		dst += _screen.pitch;
+	} while (--height);
+}
+
+void Blitter_32bppAVX2::DrawColourMappingRect(void *dst, int width, int height, PaletteID pal)
+{
+	switch (pal) {
+		case PALETTE_TO_TRANSPARENT: DrawColourMappingRectAVX2<false>((Colour *) dst, width, height); return;
+		case PALETTE_NEWSPAPER:      DrawColourMappingRectAVX2<true>((Colour *) dst, width, height); return;
+		default: Blitter_32bppSSE4::DrawColourMappingRect(dst, width, height, pal); return;
+	}
+}
+
+#endif /* WITH_SSE */
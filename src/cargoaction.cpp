@@ -227,8 +227,9 @@ bool VehicleCargoReroute::operator()(CargoPacket *cp)
 		this->destination->AddToMeta(cp_new, VehicleCargoList::MTA_TRANSFER);
 	}
 
-	/* Legal, as front pushing doesn't invalidate iterators in std::list. */
-	this->destination->packets.push_front(cp_new);
+	/* Source and destination may be the same list, so don't touch the
+	 * destination's packets while the source is being iterated. */
+	this->rerouted->push_front(cp_new);
 	return cp_new == cp;
 }
 
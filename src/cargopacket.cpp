@@ -284,11 +284,10 @@ void VehicleCargoList::Append(CargoPacket *cp, MoveToAction action)
 template<class Taction>
 void VehicleCargoList::ShiftCargo(Taction action)
 {
-	Iterator it(this->packets.begin());
-	while (it != this->packets.end() && action.MaxMove() > 0) {
-		CargoPacket *cp = *it;
+	while (!this->packets.empty() && action.MaxMove() > 0) {
+		CargoPacket *cp = this->packets.front();
 		if (action(cp)) {
-			it = this->packets.erase(it);
+			this->packets.pop_front();
 		} else {
 			break;
 		}
@@ -306,18 +305,10 @@ void VehicleCargoList::ShiftCargo(Taction action)
 template<class Taction>
 void VehicleCargoList::PopCargo(Taction action)
 {
-	if (this->packets.empty()) return;
-	Iterator it(--(this->packets.end()));
-	Iterator begin(this->packets.begin());
-	while (action.MaxMove() > 0) {
-		CargoPacket *cp = *it;
+	while (!this->packets.empty() && action.MaxMove() > 0) {
+		CargoPacket *cp = this->packets.back();
 		if (action(cp)) {
-			if (it != begin) {
-				this->packets.erase(it--);
-			} else {
-				this->packets.erase(it);
-				break;
-			}
+			this->packets.pop_back();
 		} else {
 			break;
 		}
@@ -448,18 +439,17 @@ bool VehicleCargoList::Stage(bool accepted, StationID current_station, StationID
 	this->AssertCountConsistency();
 	assert(this->action_counts[MTA_LOAD] == 0);
 	this->action_counts[MTA_TRANSFER] = this->action_counts[MTA_DELIVER] = this->action_counts[MTA_KEEP] = 0;
-	Iterator deliver = this->packets.end();
-	Iterator it = this->packets.begin();
-	uint sum = 0;
+
+	/* Packets to be transferred are collected in the new list right away, the
+	 * ones to be delivered and kept are appended after them in the end. */
+	CargoPacketList staged;
+	std::vector<CargoPacket *> deliver;
+	std::vector<CargoPacket *> keep;
 
 	bool force_keep = (order_flags & OUFB_NO_UNLOAD) != 0;
 	bool force_unload = (order_flags & OUFB_UNLOAD) != 0;
 	bool force_transfer = (order_flags & (OUFB_TRANSFER | OUFB_UNLOAD)) != 0;
-	assert(this->count > 0 || it == this->packets.end());
-	while (sum < this->count) {
-		CargoPacket *cp = *it;
-
-		this->packets.erase(it++);
+	for (CargoPacket *cp : this->packets) {
 		StationID cargo_next = INVALID_STATION;
 		MoveToAction action = MTA_LOAD;
 		if (force_keep) {
@@ -510,14 +500,13 @@ bool VehicleCargoList::Stage(bool accepted, StationID current_station, StationID
 		Money share;
 		switch (action) {
 			case MTA_KEEP:
-				this->packets.push_back(cp);
-				if (deliver == this->packets.end()) --deliver;
+				keep.push_back(cp);
 				break;
 			case MTA_DELIVER:
-				this->packets.insert(deliver, cp);
+				deliver.push_back(cp);
 				break;
 			case MTA_TRANSFER:
-				this->packets.push_front(cp);
+				staged.push_front(cp);
 				/* Add feeder share here to allow reusing field for next station. */
 				share = payment->PayTransfer(cp, cp->count);
 				cp->AddFeederShare(share);
@@ -528,8 +517,10 @@ bool VehicleCargoList::Stage(bool accepted, StationID current_station, StationID
 				NOT_REACHED();
 		}
 		this->action_counts[action] += cp->count;
-		sum += cp->count;
 	}
+	staged.insert(staged.end(), deliver.begin(), deliver.end());
+	staged.insert(staged.end(), keep.begin(), keep.end());
+	this->packets.swap(staged);
 	this->AssertCountConsistency();
 	return this->action_counts[MTA_DELIVER] > 0 || this->action_counts[MTA_TRANSFER] > 0;
 }
@@ -584,7 +575,7 @@ uint VehicleCargoList::Reassign<VehicleCargoList::MTA_DELIVER, VehicleCargoList:
 		if (sum > this->action_counts[MTA_TRANSFER] + max_move) {
 			CargoPacket *cp_split = cp->Split(sum - this->action_counts[MTA_TRANSFER] + max_move);
 			sum -= cp_split->Count();
-			this->packets.insert(it, cp_split);
+			it = this->packets.insert(it, cp_split) + 1;
 		}
 		cp->next_station = next_station;
 	}
@@ -669,7 +660,9 @@ uint VehicleCargoList::Truncate(uint max_move)
 uint VehicleCargoList::Reroute(uint max_move, VehicleCargoList *dest, StationID avoid, StationID avoid2, const GoodsEntry *ge)
 {
 	max_move = std::min(this->action_counts[MTA_TRANSFER], max_move);
-	this->ShiftCargo(VehicleCargoReroute(this, dest, max_move, avoid, avoid2, ge));
+	CargoPacketList rerouted;
+	this->ShiftCargo(VehicleCargoReroute(this, dest, max_move, avoid, avoid2, ge, &rerouted));
+	dest->packets.insert(dest->packets.begin(), rerouted.begin(), rerouted.end());
 	return max_move;
 }
 
@@ -773,42 +766,59 @@ uint StationCargoList::Truncate(uint max_move, StationCargoAmountMap *cargo_per_
 	uint moved = 0;
 	uint loop = 0;
 	bool do_count = cargo_per_source != nullptr;
-	while (max_move > moved) {
-		for (Iterator it(this->packets.begin()); it != this->packets.end();) {
-			CargoPacket *cp = *it;
-			if (prev_count > max_move && RandomRange(prev_count) < prev_count - max_move) {
-				if (do_count && loop == 0) {
-					(*cargo_per_source)[cp->source] += cp->count;
-				}
-				++it;
-				continue;
-			}
-			uint diff = max_move - moved;
-			if (cp->count > diff) {
-				if (diff > 0) {
-					this->RemoveFromCache(cp, diff);
-					cp->Reduce(diff);
-					moved += diff;
+	bool done = false;
+
+	/* Removed packets are only cleared here and erased in one pass afterwards,
+	 * as erasing from the middle of a range is linear in the size of the range. */
+	StationCargoPacketMap::Map &ranges = this->packets;
+	while (!done && max_move > moved) {
+		for (auto &range : ranges) {
+			for (CargoPacket *&cp : range.second) {
+				if (cp == nullptr) continue;
+				if (prev_count > max_move && RandomRange(prev_count) < prev_count - max_move) {
+					if (do_count && loop == 0) {
+						(*cargo_per_source)[cp->source] += cp->count;
+					}
+					continue;
 				}
-				if (loop > 0) {
-					if (do_count) (*cargo_per_source)[cp->source] -= diff;
-					return moved;
+				uint diff = max_move - moved;
+				if (cp->count > diff) {
+					if (diff > 0) {
+						this->RemoveFromCache(cp, diff);
+						cp->Reduce(diff);
+						moved += diff;
+					}
+					if (loop > 0) {
+						if (do_count) (*cargo_per_source)[cp->source] -= diff;
+						done = true;
+						break;
+					} else {
+						if (do_count) (*cargo_per_source)[cp->source] += cp->count;
+					}
 				} else {
-					if (do_count) (*cargo_per_source)[cp->source] += cp->count;
-					++it;
-				}
-			} else {
-				it = this->packets.erase(it);
-				if (do_count && loop > 0) {
-					(*cargo_per_source)[cp->source] -= cp->count;
+					if (do_count && loop > 0) {
+						(*cargo_per_source)[cp->source] -= cp->count;
+					}
+					moved += cp->count;
+					this->RemoveFromCache(cp, cp->count);
+					delete cp;
+					cp = nullptr;
 				}
-				moved += cp->count;
-				this->RemoveFromCache(cp, cp->count);
-				delete cp;
 			}
+			if (done) break;
 		}
 		loop++;
 	}
+
+	for (auto it = ranges.begin(); it != ranges.end();) {
+		StationCargoPacketMap::List &list = it->second;
+		list.erase(std::remove(list.begin(), list.end(), nullptr), list.end());
+		if (list.empty()) {
+			it = ranges.erase(it);
+		} else {
+			++it;
+		}
+	}
 	return moved;
 }
 
@@ -259,14 +259,20 @@ static void TileLoop_Clear(TileIndex tile)
 	}
 	AmbientSoundEffect(tile);
 
+	/* Without snow or desert, fully grown grass and rough land stay the same until their ground is changed. */
+	bool inert = false;
 	switch (_settings_game.game_creation.landscape) {
 		case LT_TROPIC: TileLoopClearDesert(tile); break;
 		case LT_ARCTIC: TileLoopClearAlps(tile);   break;
+		default: inert = !_settings_game.construction.freeform_edges || DistanceFromEdge(tile) != 1; break;
 	}
 
 	switch (GetClearGround(tile)) {
 		case CLEAR_GRASS:
-			if (GetClearDensity(tile) == 3) return;
+			if (GetClearDensity(tile) == 3) {
+				if (inert) tile_map.inert_tiles[tile] = true;
+				return;
+			}
 
 			if (_game_mode != GM_EDITOR) {
 				if (GetClearCounter(tile) < 7) {
@@ -304,6 +310,7 @@ static void TileLoop_Clear(TileIndex tile)
 			break;
 
 		default:
+			if (inert) tile_map.inert_tiles[tile] = true;
 			return;
 	}
 
@@ -92,6 +92,7 @@ static inline uint GetClearDensity(TileIndex t)
 static inline void AddClearDensity(TileIndex t, int d)
 {
 	tile_map.clear(t).density += d;
+	tile_map.inert_tiles[t] = false;
 }
 
 /**
@@ -103,6 +104,7 @@ static inline void AddClearDensity(TileIndex t, int d)
 static inline void SetClearDensity(TileIndex t, uint d)
 {
 	tile_map.clear(t).density = d;
+	tile_map.inert_tiles[t] = false;
 }
 
 
@@ -152,6 +154,7 @@ static inline void SetClearGroundDensity(TileIndex t, ClearGround type, uint den
 	tile_map.clear(t).density = density;
 	tile_map.clear(t).ground_type = type;
 	tile_map.clear(t).counter = 0;
+	tile_map.inert_tiles[t] = false;
 }
 
 
@@ -31,6 +31,7 @@
 #include "vehicle_base.h"
 #include "vehicle_func.h"
 #include "smallmap_gui.h"
+#include "screenshot.h"
 #include "game/game.hpp"
 #include "goal_base.h"
 #include "story_base.h"
@@ -1008,6 +1009,7 @@ CommandCost CmdSetCompanyColour(DoCommandFlag flags, LiveryScheme scheme, bool p
 		}
 
 		ResetVehicleColourMap();
+		InvalidateMapTiles();
 		MarkWholeScreenDirty();
 
 		/* All graph related to companies use the company colour. */
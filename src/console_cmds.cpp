@@ -1552,6 +1552,42 @@ DEF_CONSOLE_CMD(ConScreenShot)
 	return true;
 }
 
+DEF_CONSOLE_CMD(ConExportTiles)
+{
+	if (argc == 0) {
+		IConsolePrint(CC_HELP, "Export the map as PNG tiles for web map viewers. Usage: 'export_tiles [full] [<directory>]'.");
+		IConsolePrint(CC_HELP, "  The tiles are written to '<directory>/<zoom>/<x>/<y>.png' in the screenshot directory; the default directory is 'tiles'.");
+		IConsolePrint(CC_HELP, "  Only the tiles that changed since the last export to the same directory are written again, unless 'full' is given.");
+		return true;
+	}
+
+	if (argc > 3) return false;
+
+	uint arg_index = 1;
+	bool full = false;
+	if (argc > arg_index && strcmp(argv[arg_index], "full") == 0) {
+		full = true;
+		arg_index++;
+	}
+
+	std::string name = "tiles";
+	if (argc > arg_index) name = argv[arg_index++];
+	if (argc > arg_index) return false;
+
+	if (_game_mode == GM_MENU) {
+		IConsolePrint(CC_ERROR, "There is no map to export.");
+		return true;
+	}
+
+	uint num_written;
+	if (ExportMapTiles(name, full, &num_written)) {
+		IConsolePrint(CC_DEFAULT, "Exported {} map tiles to '{}'.", num_written, name);
+	} else {
+		IConsolePrint(CC_ERROR, "Exporting the map tiles to '{}' failed.", name);
+	}
+	return true;
+}
+
 DEF_CONSOLE_CMD(ConInfoCmd)
 {
 	if (argc == 0) {
@@ -2458,6 +2494,7 @@ void IConsoleStdLibRegister()
 	IConsole::CmdRegister("reset_enginepool",        ConResetEnginePool,  ConHookNoNetwork);
 	IConsole::CmdRegister("return",                  ConReturn);
 	IConsole::CmdRegister("screenshot",              ConScreenShot);
+	IConsole::CmdRegister("export_tiles",            ConExportTiles);
 	IConsole::CmdRegister("script",                  ConScript);
 	IConsole::CmdRegister("zoomto",                  ConZoomToLevel);
 	IConsole::CmdRegister("scrollto",                ConScrollToTile);
@@ -32,4 +32,16 @@ void ottd_cpuid(int info[4], int type);
  */
 bool HasCPUIDFlag(uint type, uint index, uint bit);
 
+/**
+ * Get the extended control register XCR0, which tells which register states the OS saves.
+ * @return The register, or zero on architectures without XGETBV.
+ */
+uint64 ottd_xgetbv();
+
+/**
+ * Check whether the current CPU and OS support AVX2 instructions.
+ * @return True when AVX2 can be used.
+ */
+bool HasAVX2Support();
+
 #endif /* CPU_H */
@@ -28,6 +28,13 @@ Month     _cur_month;  ///< Current month (0..11)
 Date      _date;       ///< Current date in days (day counter)
 DateFract _date_fract; ///< Fractional part of the day.
 uint64 _tick_counter;  ///< Ever incrementing tick counter for setting off various events
+byte _periodic_loops_pending; ///< Periodic loops whose steps still have to run today, see #PeriodicLoop.
+
+/** Periodic loops with a part that is spread over the ticks of the first day of the period. */
+enum PeriodicLoop {
+	PL_MONTHLY, ///< The monthly loop.
+	PL_YEARLY,  ///< The yearly loop.
+};
 
 /**
  * Set the date.
@@ -165,14 +172,15 @@ extern void IndustryDailyLoop();
 
 extern void CompaniesMonthlyLoop();
 extern void EnginesMonthlyLoop();
-extern void TownsMonthlyLoop();
+extern void TownsMonthlyLoopStep(uint step);
 extern void IndustryMonthlyLoop();
+extern void IndustryMonthlyLoopStep(uint step);
 extern void StationMonthlyLoop();
 extern void SubsidyMonthlyLoop();
 
 extern void CompaniesYearlyLoop();
 extern void VehiclesYearlyLoop();
-extern void TownsYearlyLoop();
+extern void TownsYearlyLoopStep(uint step);
 
 extern void ShowEndGameChart();
 
@@ -193,7 +201,7 @@ static void OnNewYear()
 {
 	CompaniesYearlyLoop();
 	VehiclesYearlyLoop();
-	TownsYearlyLoop();
+	SetBit(_periodic_loops_pending, PL_YEARLY);
 	InvalidateWindowClassesData(WC_BUILD_STATION);
 	if (_network_server) NetworkServerYearlyLoop();
 
@@ -235,9 +243,8 @@ static void OnNewMonth()
 	SetWindowClassesDirty(WC_CHEATS);
 	CompaniesMonthlyLoop();
 	EnginesMonthlyLoop();
-	TownsMonthlyLoop();
+	SetBit(_periodic_loops_pending, PL_MONTHLY);
 	IndustryMonthlyLoop();
-	SubsidyMonthlyLoop();
 	StationMonthlyLoop();
 	if (_network_server) NetworkServerMonthlyLoop();
 }
@@ -263,6 +270,37 @@ static void OnNewDay()
 	SetWindowClassesDirty(WC_TOWN_VIEW);
 }
 
+/**
+ * Runs the step of the periodic loops for the current tick.
+ * The loops over all towns, industries and houses are spread over the ticks
+ * of the first day of the month or year, so the tick of the date change does
+ * not have to handle all of them at once. Each step handles the objects for
+ * the current fraction of the day in index order; every object is handled once.
+ * Towns and industries that are created during the first day are only handled
+ * that month when their index belongs to a step that has not run yet. The ones
+ * built by the monthly and daily loops exist before the first step, so they are
+ * always handled.
+ * The subsidies use the statistics of the previous month, so they are only
+ * updated after the last step has rolled over the statistics of all towns and
+ * industries.
+ */
+static void RunPeriodicLoopSteps()
+{
+	if (_periodic_loops_pending == 0) return;
+
+	uint step = _date_fract;
+	if (HasBit(_periodic_loops_pending, PL_MONTHLY)) {
+		TownsMonthlyLoopStep(step);
+		IndustryMonthlyLoopStep(step);
+	}
+	if (HasBit(_periodic_loops_pending, PL_YEARLY)) TownsYearlyLoopStep(step);
+
+	if (step == DAY_TICKS - 1) {
+		if (HasBit(_periodic_loops_pending, PL_MONTHLY)) SubsidyMonthlyLoop();
+		_periodic_loops_pending = 0;
+	}
+}
+
 /**
  * Increases the tick counter, increases date  and possibly calls
  * procedures that have to be called daily, monthly or yearly.
@@ -275,7 +313,10 @@ void IncreaseDate()
 	if (_game_mode == GM_MENU) return;
 
 	_date_fract++;
-	if (_date_fract < DAY_TICKS) return;
+	if (_date_fract < DAY_TICKS) {
+		RunPeriodicLoopSteps();
+		return;
+	}
 	_date_fract = 0;
 
 	/* increase day counter */
@@ -302,4 +343,6 @@ void IncreaseDate()
 
 	/* yes, call various yearly loops */
 	if (new_year) OnNewYear();
+
+	RunPeriodicLoopSteps();
 }
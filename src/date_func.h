@@ -17,6 +17,7 @@ extern Month     _cur_month;
 extern Date      _date;
 extern DateFract _date_fract;
 extern uint64 _tick_counter;
+extern byte _periodic_loops_pending;
 
 void SetDate(Date date, DateFract fract);
 void ConvertDateToYMD(Date date, YearMonthDay *ymd);
@@ -51,6 +51,9 @@
 #include "company_cmd.h"
 #include "economy_cmd.h"
 #include "vehicle_cmd.h"
+#include "thread_pool.h"
+#include "screenshot.h"
+#include <array>
 
 #include "table/strings.h"
 #include "table/pricebase.h"
@@ -102,61 +105,166 @@ Prices _price;
 static PriceMultipliers _price_base_multiplier;
 
 /**
- * Calculate the value of the company. That is the value of all
- * assets (vehicles, stations, shares) and money minus the loan,
- * except when including_loan is \c false which is useful when
- * we want to calculate the value for bankruptcy.
- * @param c the company to get the value of.
- * @param including_loan include the loan in the company value.
- * @return the value of the company.
+ * Add the totals of another part of the pools to these totals.
+ * @param other The totals to add.
  */
-Money CalculateCompanyValue(const Company *c, bool including_loan)
+void CompanyAssetTotals::Add(const CompanyAssetTotals &other)
 {
-	Money owned_shares_value = 0;
+	this->vehicle_value += other.vehicle_value;
+	this->facilities += other.facilities;
+	this->serviced_facilities += other.serviced_facilities;
+	this->profitable_vehicles += other.profitable_vehicles;
+	if (other.has_min_profit && (!this->has_min_profit || other.min_profit < this->min_profit)) {
+		this->min_profit = other.min_profit;
+		this->has_min_profit = true;
+	}
+}
 
-	for (const Company *co : Company::Iterate()) {
-		uint8 shares_owned = 0;
+bool CompanyAssetTotals::operator ==(const CompanyAssetTotals &other) const
+{
+	return this->vehicle_value == other.vehicle_value && this->facilities == other.facilities &&
+			this->serviced_facilities == other.serviced_facilities && this->profitable_vehicles == other.profitable_vehicles &&
+			this->has_min_profit == other.has_min_profit && this->min_profit == other.min_profit;
+}
 
-		for (uint8 i = 0; i < 4; i++) {
-			if (co->share_owners[i] == c->index) {
-				shares_owned++;
+/**
+ * Gather the totals over the vehicles and stations of all companies in one pass.
+ * The pools are split into chunks that are reduced independently, possibly on
+ * the worker threads, and merged afterwards. As the totals are only sums and
+ * minimums the result does not depend on how the work was split.
+ * @param[out] totals The totals of each company.
+ * @param parallel Whether to use the worker threads.
+ */
+void GatherCompanyAssetTotals(CompanyAssetTotals totals[MAX_COMPANIES], bool parallel)
+{
+	static const size_t CHUNK_SIZE = 1024; ///< Number of pool items reduced by one work item.
+
+	const size_t vehicle_pool_size = Vehicle::GetPoolSize();
+	const size_t station_pool_size = Station::GetPoolSize();
+	const uint vehicle_chunks = (uint)CeilDiv(vehicle_pool_size, CHUNK_SIZE);
+	const uint station_chunks = (uint)CeilDiv(station_pool_size, CHUNK_SIZE);
+	std::vector<std::array<CompanyAssetTotals, MAX_COMPANIES>> parts(vehicle_chunks + station_chunks);
+
+	auto reduce = [&](uint chunk) {
+		CompanyAssetTotals *part = parts[chunk].data();
+
+		if (chunk < vehicle_chunks) {
+			size_t end = std::min((chunk + 1) * CHUNK_SIZE, vehicle_pool_size);
+			for (size_t i = chunk * CHUNK_SIZE; i < end; i++) {
+				const Vehicle *v = Vehicle::GetIfValid(i);
+				if (v == nullptr || v->owner >= MAX_COMPANIES) continue;
+				CompanyAssetTotals &t = part[v->owner];
+
+				if (v->type == VEH_TRAIN ||
+						v->type == VEH_ROAD ||
+						(v->type == VEH_AIRCRAFT && Aircraft::From(v)->IsNormalAircraft()) ||
+						v->type == VEH_SHIP) {
+					t.vehicle_value += v->value * 3 >> 1;
+				}
+
+				if (IsCompanyBuildableVehicleType(v->type) && v->IsPrimaryVehicle()) {
+					if (v->profit_last_year > 0) t.profitable_vehicles++; // For the vehicle score only count profitable vehicles
+					if (v->age > 730 && (!t.has_min_profit || t.min_profit > v->profit_last_year)) {
+						/* Find the vehicle with the lowest amount of profit */
+						t.min_profit = v->profit_last_year;
+						t.has_min_profit = true;
+					}
+				}
+			}
+		} else {
+			chunk -= vehicle_chunks;
+			size_t end = std::min((chunk + 1) * CHUNK_SIZE, station_pool_size);
+			for (size_t i = chunk * CHUNK_SIZE; i < end; i++) {
+				const Station *st = Station::GetIfValid(i);
+				if (st == nullptr || st->owner >= MAX_COMPANIES) continue;
+				CompanyAssetTotals &t = part[st->owner];
+
+				uint num = CountBits((byte)st->facilities);
+				t.facilities += num;
+				/* Only count stations that are actually serviced */
+				if (st->time_since_load <= 20 || st->time_since_unload <= 20) t.serviced_facilities += num;
 			}
 		}
+	};
 
-		owned_shares_value += (CalculateCompanyValueExcludingShares(co) / 4) * shares_owned;
+	if (parallel) {
+		ParallelFor((uint)parts.size(), reduce);
+	} else {
+		for (uint chunk = 0; chunk < parts.size(); chunk++) reduce(chunk);
 	}
 
-	return std::max<Money>(owned_shares_value + CalculateCompanyValueExcludingShares(c), 1);
+	for (uint c = 0; c < MAX_COMPANIES; c++) {
+		totals[c] = {};
+		for (const auto &part : parts) totals[c].Add(part[c]);
+	}
 }
 
-Money CalculateCompanyValueExcludingShares(const Company *c, bool including_loan)
+/**
+ * Calculate the value of the company, excluding the shares it owns in other companies.
+ * @param c The company to get the value of.
+ * @param including_loan Subtract the loan from the value.
+ * @param totals The asset totals of all companies.
+ * @return The value of the company.
+ */
+static Money CalculateCompanyValueExcludingShares(const Company *c, bool including_loan, const CompanyAssetTotals totals[MAX_COMPANIES])
 {
-	Owner owner = c->index;
+	const CompanyAssetTotals &t = totals[c->index];
+	Money value = t.facilities * _price[PR_STATION_VALUE] * 25;
+	value += t.vehicle_value;
 
-	uint num = 0;
+	/* Add real money value */
+	if (including_loan) value -= c->current_loan;
+	value += c->money;
 
-	for (const Station *st : Station::Iterate()) {
-		if (st->owner == owner) num += CountBits((byte)st->facilities);
-	}
+	return std::max<Money>(value, 1);
+}
 
-	Money value = num * _price[PR_STATION_VALUE] * 25;
+/**
+ * Calculate the value of the company, including the shares it owns in other companies.
+ * @param c The company to get the value of.
+ * @param totals The asset totals of all companies.
+ * @return The value of the company.
+ */
+static Money CalculateCompanyValue(const Company *c, const CompanyAssetTotals totals[MAX_COMPANIES])
+{
+	Money owned_shares_value = 0;
 
-	for (const Vehicle *v : Vehicle::Iterate()) {
-		if (v->owner != owner) continue;
+	for (const Company *co : Company::Iterate()) {
+		uint8 shares_owned = 0;
 
-		if (v->type == VEH_TRAIN ||
-				v->type == VEH_ROAD ||
-				(v->type == VEH_AIRCRAFT && Aircraft::From(v)->IsNormalAircraft()) ||
-				v->type == VEH_SHIP) {
-			value += v->value * 3 >> 1;
+		for (uint8 i = 0; i < 4; i++) {
+			if (co->share_owners[i] == c->index) {
+				shares_owned++;
+			}
 		}
+
+		if (shares_owned != 0) owned_shares_value += (CalculateCompanyValueExcludingShares(co, true, totals) / 4) * shares_owned;
 	}
 
-	/* Add real money value */
-	if (including_loan) value -= c->current_loan;
-	value += c->money;
+	return std::max<Money>(owned_shares_value + CalculateCompanyValueExcludingShares(c, true, totals), 1);
+}
 
-	return std::max<Money>(value, 1);
+/**
+ * Calculate the value of the company. That is the value of all
+ * assets (vehicles, stations, shares) and money minus the loan,
+ * except when including_loan is \c false which is useful when
+ * we want to calculate the value for bankruptcy.
+ * @param c the company to get the value of.
+ * @param including_loan include the loan in the company value.
+ * @return the value of the company.
+ */
+Money CalculateCompanyValue(const Company *c, bool including_loan)
+{
+	CompanyAssetTotals totals[MAX_COMPANIES];
+	GatherCompanyAssetTotals(totals);
+	return CalculateCompanyValue(c, totals);
+}
+
+Money CalculateCompanyValueExcludingShares(const Company *c, bool including_loan)
+{
+	CompanyAssetTotals totals[MAX_COMPANIES];
+	GatherCompanyAssetTotals(totals);
+	return CalculateCompanyValueExcludingShares(c, including_loan, totals);
 }
 
 /**
@@ -164,10 +272,11 @@ Money CalculateCompanyValueExcludingShares(const Company *c, bool including_loan
  *  (also the house is updated, should only be true in the on-tick event)
  * @param update the economy with calculated score
  * @param c company been evaluated
+ * @param totals The asset totals of all companies.
  * @return actual score of this company
  *
  */
-int UpdateCompanyRatingAndValue(Company *c, bool update)
+int UpdateCompanyRatingAndValue(Company *c, bool update, const CompanyAssetTotals totals[MAX_COMPANIES])
 {
 	Owner owner = c->index;
 	int score = 0;
@@ -176,27 +285,12 @@ int UpdateCompanyRatingAndValue(Company *c, bool update)
 
 	/* Count vehicles */
 	{
-		Money min_profit = 0;
-		bool min_profit_first = true;
-		uint num = 0;
-
-		for (const Vehicle *v : Vehicle::Iterate()) {
-			if (v->owner != owner) continue;
-			if (IsCompanyBuildableVehicleType(v->type) && v->IsPrimaryVehicle()) {
-				if (v->profit_last_year > 0) num++; // For the vehicle score only count profitable vehicles
-				if (v->age > 730) {
-					/* Find the vehicle with the lowest amount of profit */
-					if (min_profit_first || min_profit > v->profit_last_year) {
-						min_profit = v->profit_last_year;
-						min_profit_first = false;
-					}
-				}
-			}
-		}
+		const CompanyAssetTotals &t = totals[owner];
+		Money min_profit = t.min_profit;
 
 		min_profit >>= 8; // remove the fract part
 
-		_score_part[owner][SCORE_VEHICLES] = num;
+		_score_part[owner][SCORE_VEHICLES] = t.profitable_vehicles;
 		/* Don't allow negative min_profit to show */
 		if (min_profit > 0) {
 			_score_part[owner][SCORE_MIN_PROFIT] = min_profit;
@@ -204,14 +298,7 @@ int UpdateCompanyRatingAndValue(Company *c, bool update)
 	}
 
 	/* Count stations */
-	{
-		uint num = 0;
-		for (const Station *st : Station::Iterate()) {
-			/* Only count stations that are actually serviced */
-			if (st->owner == owner && (st->time_since_load <= 20 || st->time_since_unload <= 20)) num += CountBits((byte)st->facilities);
-		}
-		_score_part[owner][SCORE_STATIONS] = num;
-	}
+	_score_part[owner][SCORE_STATIONS] = totals[owner].serviced_facilities;
 
 	/* Generate statistics depending on recent income statistics */
 	{
@@ -288,13 +375,27 @@ int UpdateCompanyRatingAndValue(Company *c, bool update)
 	if (update) {
 		c->old_economy[0].performance_history = score;
 		UpdateCompanyHQ(c->location_of_HQ, score);
-		c->old_economy[0].company_value = CalculateCompanyValue(c);
+		c->old_economy[0].company_value = CalculateCompanyValue(c, totals);
 	}
 
 	SetWindowDirty(WC_PERFORMANCE_DETAIL, 0);
 	return score;
 }
 
+/**
+ * if update is set to true, the economy is updated with this score
+ *  (also the house is updated, should only be true in the on-tick event)
+ * @param update the economy with calculated score
+ * @param c company been evaluated
+ * @return actual score of this company
+ */
+int UpdateCompanyRatingAndValue(Company *c, bool update)
+{
+	CompanyAssetTotals totals[MAX_COMPANIES];
+	GatherCompanyAssetTotals(totals);
+	return UpdateCompanyRatingAndValue(c, update, totals);
+}
+
 /**
  * Change the ownership of all the items of a company.
  * @param old_owner The company that gets removed.
@@ -497,6 +598,9 @@ void ChangeOwnershipOfCompanyItems(Owner old_owner, Owner new_owner)
 			ChangeTileOwner(tile, old_owner, new_owner);
 		} while (++tile != tile_map.size);
 
+		/* Signal blocks end at tiles of other owners. */
+		InvalidateSignalBlocks();
+
 		if (new_owner != INVALID_OWNER) {
 			/* Update all signals because there can be new segment that was owned by two companies
 			 * and signals were not propagated
@@ -561,6 +665,7 @@ void ChangeOwnershipOfCompanyItems(Owner old_owner, Owner new_owner)
 
 	cur_company.Restore();
 
+	InvalidateMapTiles();
 	MarkWholeScreenDirty();
 }
 
@@ -696,6 +801,10 @@ static void CompaniesGenStatistics()
 	/* Only run the economic statics and update company stats every 3rd month (1st of quarter). */
 	if (!HasBit(1 << 0 | 1 << 3 | 1 << 6 | 1 << 9, _cur_month)) return;
 
+	/* Rating a company does not change any assets, so gather them once for all companies. */
+	CompanyAssetTotals totals[MAX_COMPANIES];
+	GatherCompanyAssetTotals(totals);
+
 	for (Company *c : Company::Iterate()) {
 		/* Drop the oldest history off the end */
 		std::copy_backward(c->old_economy, c->old_economy + MAX_HISTORY_QUARTERS - 1, c->old_economy + MAX_HISTORY_QUARTERS);
@@ -704,7 +813,7 @@ static void CompaniesGenStatistics()
 
 		if (c->num_valid_stat_ent != MAX_HISTORY_QUARTERS) c->num_valid_stat_ent++;
 
-		UpdateCompanyRatingAndValue(c, true);
+		UpdateCompanyRatingAndValue(c, true, totals);
 		if (c->block_preview != 0) c->block_preview--;
 	}
 
@@ -25,7 +25,23 @@ extern Economy _economy;
 /* Prices and also the fractional part. */
 extern Prices _price;
 
+/** Totals over the vehicles and stations of a company, for its value and performance rating. */
+struct CompanyAssetTotals {
+	Money vehicle_value = 0;      ///< Value of the vehicles that count for the company value, times 1.5.
+	uint facilities = 0;          ///< Number of facilities of all stations.
+	uint serviced_facilities = 0; ///< Number of facilities of the stations that were recently serviced.
+	uint profitable_vehicles = 0; ///< Number of primary vehicles that made a profit last year.
+	Money min_profit = 0;         ///< Lowest profit last year of the primary vehicles older than two years.
+	bool has_min_profit = false;  ///< Whether any primary vehicle is older than two years.
+
+	void Add(const CompanyAssetTotals &other);
+	bool operator ==(const CompanyAssetTotals &other) const;
+	bool operator !=(const CompanyAssetTotals &other) const { return !(*this == other); }
+};
+
+void GatherCompanyAssetTotals(CompanyAssetTotals totals[MAX_COMPANIES], bool parallel = true);
 int UpdateCompanyRatingAndValue(Company *c, bool update);
+int UpdateCompanyRatingAndValue(Company *c, bool update, const CompanyAssetTotals totals[MAX_COMPANIES]);
 void StartupIndustryDailyChanges(bool init_counter);
 
 Money GetTransportedGoodsIncome(uint num_pieces, uint dist, byte transit_days, CargoID cargo_type);
@@ -18,6 +18,9 @@
 #include "console_func.h"
 #include "console_type.h"
 #include "guitimer_func.h"
+#include "spritecache.h"
+#include "gfx_layout.h"
+#include "landscape.h"
 #include "company_base.h"
 #include "ai/ai_info.hpp"
 #include "ai/ai_instance.hpp"
@@ -136,6 +139,17 @@ namespace {
 			return sumtime * 1000 / count / TIMESTAMP_PRECISION;
 		}
 
+		/** Get the longest processing time of all recorded data points */
+		double GetPeakDurationMilliseconds()
+		{
+			TimingMeasurement peak = 0;
+			for (int i = 0; i < this->num_valid; i++) {
+				auto d = this->durations[i];
+				if (d != INVALID_DURATION) peak = std::max(peak, d);
+			}
+			return (double)peak * 1000 / TIMESTAMP_PRECISION;
+		}
+
 		/** Get current rate of a performance element, based on approximately the past one second of data */
 		double GetRate()
 		{
@@ -362,6 +376,10 @@ static const NWidgetPart _framerate_window_widgets[] = {
 			NWidget(WWT_TEXT, COLOUR_GREY, WID_FRW_RATE_GAMELOOP), SetDataTip(STR_FRAMERATE_RATE_GAMELOOP, STR_FRAMERATE_RATE_GAMELOOP_TOOLTIP), SetFill(1, 0), SetResize(1, 0),
 			NWidget(WWT_TEXT, COLOUR_GREY, WID_FRW_RATE_DRAWING),  SetDataTip(STR_FRAMERATE_RATE_BLITTER,  STR_FRAMERATE_RATE_BLITTER_TOOLTIP), SetFill(1, 0), SetResize(1, 0),
 			NWidget(WWT_TEXT, COLOUR_GREY, WID_FRW_RATE_FACTOR),   SetDataTip(STR_FRAMERATE_SPEED_FACTOR,  STR_FRAMERATE_SPEED_FACTOR_TOOLTIP), SetFill(1, 0), SetResize(1, 0),
+			NWidget(WWT_TEXT, COLOUR_GREY, WID_FRW_PEAK_GAMELOOP), SetDataTip(STR_FRAMERATE_PEAK_GAMELOOP, STR_FRAMERATE_PEAK_GAMELOOP_TOOLTIP), SetFill(1, 0), SetResize(1, 0),
+			NWidget(WWT_TEXT, COLOUR_GREY, WID_FRW_SPRITE_CACHE),  SetDataTip(STR_FRAMERATE_SPRITE_CACHE,  STR_FRAMERATE_SPRITE_CACHE_TOOLTIP), SetFill(1, 0), SetResize(1, 0),
+			NWidget(WWT_TEXT, COLOUR_GREY, WID_FRW_LINE_CACHE),    SetDataTip(STR_FRAMERATE_LINE_CACHE,    STR_FRAMERATE_LINE_CACHE_TOOLTIP), SetFill(1, 0), SetResize(1, 0),
+			NWidget(WWT_TEXT, COLOUR_GREY, WID_FRW_TILE_LOOP),     SetDataTip(STR_FRAMERATE_TILE_LOOP,     STR_FRAMERATE_TILE_LOOP_TOOLTIP), SetFill(1, 0), SetResize(1, 0),
 		EndContainer(),
 	EndContainer(),
 	NWidget(NWID_HORIZONTAL),
@@ -422,8 +440,12 @@ struct FramerateWindow : Window {
 	CachedDecimal rate_gameloop;            ///< cached game loop tick rate
 	CachedDecimal rate_drawing;             ///< cached drawing frame rate
 	CachedDecimal speed_gameloop;           ///< cached game loop speed factor
+	CachedDecimal peak_gameloop;            ///< cached longest game loop tick time
 	CachedDecimal times_shortterm[PFE_MAX]; ///< cached short term average times
 	CachedDecimal times_longterm[PFE_MAX];  ///< cached long term average times
+	SpriteCacheStatistics sprite_cache;     ///< cached sprite cache statistics
+	LineCacheStatistics line_cache;         ///< cached text layout cache statistics
+	TileLoopStatistics tile_loop;           ///< cached tile loop statistics
 
 	static constexpr int VSPACING = 3;          ///< space between column heading and values
 	static constexpr int MIN_ELEMENTS = 5;      ///< smallest number of elements to display
@@ -468,6 +490,10 @@ struct FramerateWindow : Window {
 		if (this->small) return; // in small mode, this is everything needed
 
 		this->rate_drawing.SetRate(_pf_data[PFE_DRAWING].GetRate(), _settings_client.gui.refresh_rate);
+		this->peak_gameloop.SetTime(_pf_data[PFE_GAMELOOP].GetPeakDurationMilliseconds(), MILLISECONDS_PER_TICK);
+		this->sprite_cache = GetSpriteCacheStatistics();
+		this->line_cache = Layouter::GetLineCacheStatistics();
+		this->tile_loop = GetTileLoopStatistics();
 
 		int new_active = 0;
 		for (PerformanceElement e = PFE_FIRST; e < PFE_MAX; e++) {
@@ -516,6 +542,38 @@ struct FramerateWindow : Window {
 			case WID_FRW_RATE_FACTOR:
 				this->speed_gameloop.InsertDParams(0);
 				break;
+			case WID_FRW_PEAK_GAMELOOP:
+				SetDParam(0, NUM_FRAMERATE_POINTS);
+				SetDParam(1, this->peak_gameloop.strid);
+				this->peak_gameloop.InsertDParams(2);
+				break;
+			case WID_FRW_SPRITE_CACHE: {
+				const SpriteCacheStatistics &sc = this->sprite_cache;
+				uint64 requests = sc.hits + sc.misses;
+				SetDParam(0, sc.allocated);
+				SetDParam(1, sc.budget);
+				SetDParam(2, requests == 0 ? 0 : sc.hits * 10000 / requests);
+				SetDParam(3, 2);
+				SetDParam(4, sc.evictions);
+				SetDParam(5, sc.allocated == 0 ? 0 : (uint64)(sc.allocated - sc.requested) * 10000 / sc.allocated);
+				SetDParam(6, 2);
+				break;
+			}
+			case WID_FRW_LINE_CACHE: {
+				const LineCacheStatistics &lc = this->line_cache;
+				uint64 requests = lc.hits + lc.misses;
+				SetDParam(0, lc.lines);
+				SetDParam(1, requests == 0 ? 0 : lc.hits * 10000 / requests);
+				SetDParam(2, 2);
+				SetDParam(3, lc.evictions);
+				break;
+			}
+			case WID_FRW_TILE_LOOP: {
+				const TileLoopStatistics &tl = this->tile_loop;
+				SetDParam(0, tl.tiles == 0 ? 0 : tl.skipped * 10000 / tl.tiles);
+				SetDParam(1, 2);
+				break;
+			}
 			case WID_FRW_INFO_DATA_POINTS:
 				SetDParam(0, NUM_FRAMERATE_POINTS);
 				break;
@@ -542,6 +600,35 @@ struct FramerateWindow : Window {
 				SetDParam(1, 2);
 				*size = GetStringBoundingBox(STR_FRAMERATE_SPEED_FACTOR);
 				break;
+			case WID_FRW_PEAK_GAMELOOP:
+				SetDParam(0, NUM_FRAMERATE_POINTS);
+				SetDParam(1, STR_FRAMERATE_MS_GOOD);
+				SetDParam(2, 999999);
+				SetDParam(3, 2);
+				*size = GetStringBoundingBox(STR_FRAMERATE_PEAK_GAMELOOP);
+				break;
+			case WID_FRW_SPRITE_CACHE:
+				SetDParam(0, INT32_MAX);
+				SetDParam(1, INT32_MAX);
+				SetDParam(2, 10000);
+				SetDParam(3, 2);
+				SetDParam(4, 99999999);
+				SetDParam(5, 10000);
+				SetDParam(6, 2);
+				*size = GetStringBoundingBox(STR_FRAMERATE_SPRITE_CACHE);
+				break;
+			case WID_FRW_LINE_CACHE:
+				SetDParam(0, 99999);
+				SetDParam(1, 10000);
+				SetDParam(2, 2);
+				SetDParam(3, 99999999);
+				*size = GetStringBoundingBox(STR_FRAMERATE_LINE_CACHE);
+				break;
+			case WID_FRW_TILE_LOOP:
+				SetDParam(0, 10000);
+				SetDParam(1, 2);
+				*size = GetStringBoundingBox(STR_FRAMERATE_TILE_LOOP);
+				break;
 
 			case WID_FRW_TIMES_NAMES: {
 				size->width = 0;
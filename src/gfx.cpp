@@ -21,6 +21,7 @@
 #include "newgrf_debug.h"
 #include "thread.h"
 #include "core/backup_type.hpp"
+#include "smallmap_gui.h"
 
 #include "table/palettes.h"
 #include "table/string_colours.h"
@@ -450,21 +451,31 @@ void DrawBox(int x, int y, int dx1, int dy1, int dx2, int dy2, int dx3, int dy3)
 }
 
 /**
- * Set the colour remap to be for the given colour.
- * @param colour the new colour of the remap.
+ * Fill a string colour remap for the given colour.
+ * @param remap  the remap to fill.
+ * @param colour the colour of the remap.
  */
-static void SetColourRemap(TextColour colour)
+static void FillColourRemap(byte remap[3], TextColour colour)
 {
-	if (colour == TC_INVALID) return;
-
 	/* Black strings have no shading ever; the shading is black, so it
 	 * would be invisible at best, but it actually makes it illegible. */
 	bool no_shade   = (colour & TC_NO_SHADE) != 0 || colour == TC_BLACK;
 	bool raw_colour = (colour & TC_IS_PALETTE_COLOUR) != 0;
 	colour &= ~(TC_NO_SHADE | TC_IS_PALETTE_COLOUR | TC_FORCED);
 
-	_string_colourremap[1] = raw_colour ? (byte)colour : _string_colourmap[colour];
-	_string_colourremap[2] = no_shade ? 0 : 1;
+	remap[1] = raw_colour ? (byte)colour : _string_colourmap[colour];
+	remap[2] = no_shade ? 0 : 1;
+}
+
+/**
+ * Set the colour remap to be for the given colour.
+ * @param colour the new colour of the remap.
+ */
+static void SetColourRemap(TextColour colour)
+{
+	if (colour == TC_INVALID) return;
+
+	FillColourRemap(_string_colourremap, colour);
 	_colour_remap_ptr = _string_colourremap;
 }
 
@@ -564,20 +575,23 @@ static int DrawLayoutLine(const ParagraphLayouter::Line &line, int y, int left,
 
 	TextColour colour = TC_BLACK;
 	bool draw_shadow = false;
+	DrawPixelInfo *dpi = _cur_dpi;
+	int dpi_left  = dpi->left;
+	int dpi_right = dpi->left + dpi->width - 1;
+
+	byte shadow_remap[3] = {};
+	FillColourRemap(shadow_remap, TC_BLACK);
+
 	for (int run_index = 0; run_index < line.CountRuns(); run_index++) {
 		const ParagraphLayouter::VisualRun &run = line.GetVisualRun(run_index);
 		const Font *f = (const Font*)run.GetFont();
 
 		FontCache *fc = f->fc;
 		colour = f->colour;
-		SetColourRemap(colour);
-
-		DrawPixelInfo *dpi = _cur_dpi;
-		int dpi_left  = dpi->left;
-		int dpi_right = dpi->left + dpi->width - 1;
-
 		draw_shadow = fc->GetDrawGlyphShadow() && (colour & TC_NO_SHADE) == 0 && colour != TC_BLACK;
 
+		SetColourRemap(colour);
+
 		for (int i = 0; i < run.GetGlyphCount(); i++) {
 			GlyphID glyph = run.GetGlyphs()[i];
 
@@ -595,10 +609,12 @@ static int DrawLayoutLine(const ParagraphLayouter::Line &line, int y, int left,
 			/* Check clipping (the "+ 1" is for the shadow). */
 			if (begin_x + sprite->x_offs > dpi_right || begin_x + sprite->x_offs + sprite->width /* - 1 + 1 */ < dpi_left) continue;
 
+			/* Draw the shadow directly before its glyph; only the remap pointer
+			 * is switched, the remaps themselves are not refilled per glyph. */
 			if (draw_shadow && (glyph & SPRITE_GLYPH) == 0) {
-				SetColourRemap(TC_BLACK);
+				_colour_remap_ptr = shadow_remap;
 				GfxMainBlitter(sprite, begin_x + 1, top + 1, BM_COLOUR_REMAP);
-				SetColourRemap(colour);
+				_colour_remap_ptr = _string_colourremap;
 			}
 			GfxMainBlitter(sprite, begin_x, top, BM_COLOUR_REMAP);
 		}
@@ -1750,6 +1766,8 @@ void AddDirtyBlock(int left, int top, int right, int bottom)
  */
 void MarkWholeScreenDirty()
 {
+	/* Whatever changed may affect all of the world too. */
+	InvalidateSmallMapTiles();
 	AddDirtyBlock(0, 0, _screen.width, _screen.height);
 }
 
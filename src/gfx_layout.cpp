@@ -32,6 +32,15 @@
 
 /** Cache of ParagraphLayout lines. */
 Layouter::LineCache *Layouter::linecache;
+LineCacheStatistics Layouter::linecache_stats;
+
+/** Number of lines the line cache may hold before the least recently used lines are removed. */
+static const size_t MAX_LINE_CACHE_SIZE = 4096;
+/** Number of lines left in the line cache after it has been reduced. */
+static const size_t REDUCED_LINE_CACHE_SIZE = MAX_LINE_CACHE_SIZE * 3 / 4;
+
+/** Counter that is increased for every line requested from the line cache, to track the least recently used lines. */
+static uint64 _line_cache_clock;
 
 /** Cache of Font instances. */
 Layouter::FontColourMap Layouter::fonts[FS_END];
@@ -890,14 +899,19 @@ Layouter::LineCacheItem &Layouter::GetCachedParagraphLayout(const char *str, siz
 
 	if (auto match = linecache->find(LineCacheQuery{state, std::string_view{str, len}});
 		match != linecache->end()) {
+		linecache_stats.hits++;
+		match->second.last_use = ++_line_cache_clock;
 		return match->second;
 	}
 
 	/* Create missing entry */
+	linecache_stats.misses++;
 	LineCacheKey key;
 	key.state_before = state;
 	key.str.assign(str, len);
-	return (*linecache)[key];
+	LineCacheItem &item = (*linecache)[key];
+	item.last_use = ++_line_cache_clock;
+	return item;
 }
 
 /**
@@ -910,11 +924,36 @@ void Layouter::ResetLineCache()
 
 /**
  * Reduce the size of linecache if necessary to prevent infinite growth.
+ * The least recently used lines are removed, so the lines of windows that
+ * are redrawn continuously stay laid out.
+ * @note Lines are only removed here and never while looking them up, as a
+ *       Layouter refers to the cached lines for as long as it exists.
  */
 void Layouter::ReduceLineCache()
 {
-	if (linecache != nullptr) {
-		/* TODO LRU cache would be fancy, but not exactly necessary */
-		if (linecache->size() > 4096) ResetLineCache();
-	}
+	if (linecache == nullptr || linecache->size() <= MAX_LINE_CACHE_SIZE) return;
+
+	std::vector<LineCache::iterator> lines;
+	lines.reserve(linecache->size());
+	for (auto it = linecache->begin(); it != linecache->end(); ++it) lines.push_back(it);
+
+	/* Move the lines to remove to the front; the order amongst them does not matter. */
+	size_t remove = lines.size() - REDUCED_LINE_CACHE_SIZE;
+	std::nth_element(lines.begin(), lines.begin() + remove, lines.end(), [](const LineCache::iterator &a, const LineCache::iterator &b) {
+		return a->second.last_use < b->second.last_use;
+	});
+	for (size_t i = 0; i < remove; i++) linecache->erase(lines[i]);
+
+	linecache_stats.evictions += remove;
+}
+
+/**
+ * Get the statistics of the line cache.
+ * @return The number of cached lines and how often lines were found in the cache.
+ */
+LineCacheStatistics Layouter::GetLineCacheStatistics()
+{
+	LineCacheStatistics stats = linecache_stats;
+	stats.lines = linecache == nullptr ? 0 : linecache->size();
+	return stats;
 }
@@ -145,6 +145,14 @@ public:
 	virtual std::unique_ptr<const Line> NextLine(int max_width) = 0;
 };
 
+/** Statistics of the cache of laid out lines, for the frame rate window. */
+struct LineCacheStatistics {
+	size_t lines;     ///< Number of lines in the cache.
+	uint64 hits;      ///< Number of lines that were already laid out.
+	uint64 misses;    ///< Number of lines that had to be laid out.
+	uint64 evictions; ///< Number of lines removed from the cache to keep it bounded.
+};
+
 /**
  * The layouter performs all the layout work.
  *
@@ -187,13 +195,15 @@ public:
 
 		FontState state_after;     ///< Font state after the line.
 		ParagraphLayouter *layout; ///< Layout of the line.
+		uint64 last_use;           ///< Value of the line cache clock when the line was last requested.
 
-		LineCacheItem() : buffer(nullptr), layout(nullptr) {}
+		LineCacheItem() : buffer(nullptr), layout(nullptr), last_use(0) {}
 		~LineCacheItem() { delete layout; free(buffer); }
 	};
 private:
 	typedef std::map<LineCacheKey, LineCacheItem, LineCacheCompare> LineCache;
 	static LineCache *linecache;
+	static LineCacheStatistics linecache_stats;
 
 	static LineCacheItem &GetCachedParagraphLayout(const char *str, size_t len, const FontState &state);
 
@@ -210,6 +220,7 @@ public:
 	static void ResetFontCache(FontSize size);
 	static void ResetLineCache();
 	static void ReduceLineCache();
+	static LineCacheStatistics GetLineCacheStatistics();
 };
 
 #endif /* GFX_LAYOUT_H */
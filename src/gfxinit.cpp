@@ -9,6 +9,7 @@
 
 #include "stdafx.h"
 #include "fios.h"
+#include "screenshot.h"
 #include "newgrf.h"
 #include "3rdparty/md5/md5.h"
 #include "fontcache.h"
@@ -37,17 +38,19 @@ static const SpriteID * const _landscape_spriteindexes[] = {
 
 /**
  * Load an old fashioned GRF file.
- * @param filename   The name of the file to open.
+ * @param grf        The base set file to open.
  * @param load_index The offset of the first sprite.
  * @param needs_palette_remap Whether the colours in the GRF file need a palette remap.
  * @return The number of loaded sprites.
  */
-static uint LoadGrfFile(const char *filename, uint load_index, bool needs_palette_remap)
+static uint LoadGrfFile(const MD5File &grf, uint load_index, bool needs_palette_remap)
 {
+	const char *filename = grf.filename;
 	uint load_index_org = load_index;
 	uint sprite_id = 0;
 
 	SpriteFile &file = OpenCachedSpriteFile(filename, BASESET_DIR, needs_palette_remap);
+	if (grf.check_result == MD5File::CR_MATCH) file.SetMD5Sum(grf.hash);
 
 	Debug(sprite, 2, "Reading grf-file '{}'", filename);
 
@@ -74,17 +77,19 @@ static uint LoadGrfFile(const char *filename, uint load_index, bool needs_palett
 
 /**
  * Load an old fashioned GRF file to replace already loaded sprites.
- * @param filename   The name of the file to open.
+ * @param grf        The base set file to open.
  * @param index_tbl  The offsets of each of the sprites.
  * @param needs_palette_remap Whether the colours in the GRF file need a palette remap.
  * @return The number of loaded sprites.
  */
-static void LoadGrfFileIndexed(const char *filename, const SpriteID *index_tbl, bool needs_palette_remap)
+static void LoadGrfFileIndexed(const MD5File &grf, const SpriteID *index_tbl, bool needs_palette_remap)
 {
+	const char *filename = grf.filename;
 	uint start;
 	uint sprite_id = 0;
 
 	SpriteFile &file = OpenCachedSpriteFile(filename, BASESET_DIR, needs_palette_remap);
+	if (grf.check_result == MD5File::CR_MATCH) file.SetMD5Sum(grf.hash);
 
 	Debug(sprite, 2, "Reading indexed grf-file '{}'", filename);
 
@@ -160,7 +165,7 @@ static void LoadSpriteTables()
 {
 	const GraphicsSet *used_set = BaseGraphics::GetUsedSet();
 
-	LoadGrfFile(used_set->files[GFT_BASE].filename, 0, PAL_DOS != used_set->palette);
+	LoadGrfFile(used_set->files[GFT_BASE], 0, PAL_DOS != used_set->palette);
 
 	/*
 	 * The second basic file always starts at the given location and does
@@ -168,7 +173,7 @@ static void LoadSpriteTables()
 	 * has a few sprites less. However, we do not care about those missing
 	 * sprites as they are not shown anyway (logos in intro game).
 	 */
-	LoadGrfFile(used_set->files[GFT_LOGOS].filename, 4793, PAL_DOS != used_set->palette);
+	LoadGrfFile(used_set->files[GFT_LOGOS], 4793, PAL_DOS != used_set->palette);
 
 	/*
 	 * Load additional sprites for climates other than temperate.
@@ -177,7 +182,7 @@ static void LoadSpriteTables()
 	 */
 	if (_settings_game.game_creation.landscape != LT_TEMPERATE) {
 		LoadGrfFileIndexed(
-			used_set->files[GFT_ARCTIC + _settings_game.game_creation.landscape - 1].filename,
+			used_set->files[GFT_ARCTIC + _settings_game.game_creation.landscape - 1],
 			_landscape_spriteindexes[_settings_game.game_creation.landscape - 1],
 			PAL_DOS != used_set->palette
 		);
@@ -242,6 +247,9 @@ static void RealChangeBlitter(const char *repl_blitter)
 	if (strcmp(cur_blitter, repl_blitter) == 0) return;
 
 	Debug(driver, 1, "Switching blitter from '{}' to '{}'... ", cur_blitter, repl_blitter);
+
+	/* The prefetch threads use the current blitter to encode sprites. */
+	CancelSpritePrefetch();
 	Blitter *new_blitter = BlitterFactory::SelectBlitter(repl_blitter);
 	if (new_blitter == nullptr) NOT_REACHED();
 	Debug(driver, 1, "Successfully switched to {}.", repl_blitter);
@@ -294,6 +302,7 @@ static bool SwitchNewGRFBlitter()
 		{ "8bpp-optimized",  2,  8,  8,  8,  8 },
 		{ "40bpp-anim",      2,  8, 32,  8, 32 },
 #ifdef WITH_SSE
+		{ "32bpp-avx2",      0, 32, 32,  8, 32 },
 		{ "32bpp-sse4",      0, 32, 32,  8, 32 },
 		{ "32bpp-ssse3",     0, 32, 32,  8, 32 },
 		{ "32bpp-sse2",      0, 32, 32,  8, 32 },
@@ -351,6 +360,7 @@ void GfxLoadSprites()
 	GfxInitSpriteMem();
 	LoadSpriteTables();
 	GfxInitPalettes();
+	InvalidateMapTiles();
 
 	UpdateCursorSize();
 }
@@ -1310,8 +1310,10 @@ struct PerformanceRatingDetailWindow : Window {
 	{
 		/* Update all company stats with the current data
 		 * (this is because _score_info is not saved to a savegame) */
+		CompanyAssetTotals totals[MAX_COMPANIES];
+		GatherCompanyAssetTotals(totals);
 		for (Company *c : Company::Iterate()) {
-			UpdateCompanyRatingAndValue(c, false);
+			UpdateCompanyRatingAndValue(c, false, totals);
 		}
 
 		this->timeout = DAY_TICKS * 5;
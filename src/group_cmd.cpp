@@ -11,6 +11,7 @@
 #include "command_func.h"
 #include "train.h"
 #include "vehiclelist.h"
+#include "screenshot.h"
 #include "vehicle_func.h"
 #include "autoreplace_base.h"
 #include "autoreplace_func.h"
@@ -436,6 +437,7 @@ CommandCost CmdAlterGroup(DoCommandFlag flags, AlterGroupMode mode, GroupID grou
 				g->livery.colour2 = livery->colour2;
 
 				PropagateChildLivery(g);
+				InvalidateMapTiles();
 				MarkWholeScreenDirty();
 			}
 		}
@@ -629,6 +631,7 @@ CommandCost CmdSetGroupLivery(DoCommandFlag flags, GroupID group_id, bool primar
 		}
 
 		PropagateChildLivery(g);
+		InvalidateMapTiles();
 		MarkWholeScreenDirty();
 	}
 
@@ -20,6 +20,7 @@
 
 typedef Pool<Industry, IndustryID, 64, 64000> IndustryPool;
 extern IndustryPool _industry_pool;
+extern uint16 _industry_tick_clock;
 
 /**
  * Production level maximum, minimum and default values.
@@ -78,7 +79,7 @@ struct Industry : IndustryPool::PoolItem<&_industry_pool> {
 	byte last_month_pct_transported[INDUSTRY_NUM_OUTPUTS]; ///< percentage transported per cargo in the last full month
 	uint16 last_month_production[INDUSTRY_NUM_OUTPUTS];    ///< total units produced per cargo in the last full month
 	uint16 last_month_transported[INDUSTRY_NUM_OUTPUTS];   ///< total units transported per cargo in the last full month
-	uint16 counter;                                        ///< used for animation and/or production (if available cargo)
+	uint16 counter;                                        ///< used for animation and/or production (if available cargo); counts down with #_industry_tick_clock, use GetCounter()
 
 	IndustryType type;             ///< type of industry.
 	Owner owner;                   ///< owner of the industry.  Which SHOULD always be (imho) OWNER_NONE
@@ -109,6 +110,16 @@ struct Industry : IndustryPool::PoolItem<&_industry_pool> {
 
 	void RecomputeProductionMultipliers();
 
+	/**
+	 * Get the value of the production counter. It counts down one step each
+	 * tick, which is done for all industries at once by the industry tick clock.
+	 * @return The current value of the counter.
+	 */
+	inline uint16 GetCounter() const
+	{
+		return this->counter - _industry_tick_clock;
+	}
+
 	/**
 	 * Check if a given tile belongs to this industry.
 	 * @param tile The tile to check.
@@ -209,6 +220,9 @@ void ReleaseDisastersTargetingIndustry(IndustryID);
 
 bool IsTileForestIndustry(TileIndex tile);
 
+void RebuildIndustryProductionSchedule();
+void SyncIndustryCounters();
+
 /** Data for managing the number of industries of a single industry type. */
 struct IndustryTypeBuildData {
 	uint32 probability;  ///< Relative probability of building this industry.
@@ -11,6 +11,7 @@
 #include "clear_map.h"
 #include "industry.h"
 #include "station_base.h"
+#include "station_func.h"
 #include "landscape.h"
 #include "viewport_func.h"
 #include "command_func.h"
@@ -44,6 +45,7 @@
 #include "industry_cmd.h"
 #include "landscape_cmd.h"
 #include "terraform_cmd.h"
+#include <array>
 
 #include "table/strings.h"
 #include "table/industry_land.h"
@@ -140,6 +142,56 @@ const IndustryTileSpec *GetIndustryTileSpec(IndustryGfx gfx)
 	return &_industry_tile_specs[gfx];
 }
 
+/** Number of ticks the industry counters counted down since they were last brought up to date, see Industry::GetCounter(). */
+uint16 _industry_tick_clock;
+/** Industries in the slot of the lowest byte of their (not counted down) counter, see OnTick_Industry(). */
+static std::array<std::vector<IndustryID>, INDUSTRY_PRODUCE_TICKS> _industry_production_schedule;
+
+/**
+ * Add a new industry to the production schedule.
+ * @param i The industry.
+ */
+static void ScheduleIndustryProduction(const Industry *i)
+{
+	_industry_production_schedule[i->counter % INDUSTRY_PRODUCE_TICKS].push_back(i->index);
+}
+
+/**
+ * Remove an industry that is being deleted from the production schedule.
+ * An industry that was never fully built, e.g. when loading a game failed,
+ * is not in the schedule.
+ * @param i The industry.
+ */
+static void UnscheduleIndustryProduction(const Industry *i)
+{
+	std::vector<IndustryID> &slot = _industry_production_schedule[i->counter % INDUSTRY_PRODUCE_TICKS];
+	auto pos = std::find(slot.begin(), slot.end(), i->index);
+	if (pos != slot.end()) slot.erase(pos);
+}
+
+/**
+ * Rebuild the production schedule from the counters of the industries, e.g.\ after loading a game.
+ */
+void RebuildIndustryProductionSchedule()
+{
+	_industry_tick_clock = 0;
+	for (auto &slot : _industry_production_schedule) slot.clear();
+
+	for (const Industry *i : Industry::Iterate()) ScheduleIndustryProduction(i);
+}
+
+/**
+ * Store the current values in the counters of the industries, e.g.\ before saving the industries.
+ */
+void SyncIndustryCounters()
+{
+	for (Industry *i : Industry::Iterate()) i->counter = i->GetCounter();
+
+	/* The counters moved by the clock, so the slots move along with them. */
+	std::rotate(_industry_production_schedule.begin(), _industry_production_schedule.begin() + _industry_tick_clock % INDUSTRY_PRODUCE_TICKS, _industry_production_schedule.end());
+	_industry_tick_clock = 0;
+}
+
 Industry::~Industry()
 {
 	if (CleaningPool()) return;
@@ -149,6 +201,8 @@ Industry::~Industry()
 	 * Also we must not decrement industry counts in that case. */
 	if (this->location.w == 0) return;
 
+	UnscheduleIndustryProduction(this);
+
 	const bool has_neutral_station = this->neutral_station != nullptr;
 
 	for (TileIndex tile_cur : this->location) {
@@ -164,6 +218,8 @@ Industry::~Industry()
 		}
 	}
 
+	InvalidateStationAcceptance(this->location);
+
 	if (has_neutral_station) {
 		/* Remove possible docking tiles */
 		for (TileIndex tile_cur : this->location) {
@@ -554,6 +610,16 @@ static bool TransportIndustryGoods(TileIndex tile)
 	return moved_cargo;
 }
 
+/**
+ * Change the graphics of an industry tile, which may also change the cargo it accepts.
+ * @param tile The industry tile.
+ * @param gfx The new graphics.
+ */
+static void ChangeIndustryTileGfx(TileIndex tile, IndustryGfx gfx)
+{
+	SetIndustryGfx(tile, gfx);
+	InvalidateStationAcceptance(TileArea(tile, 1, 1));
+}
 
 static void AnimateTile_Industry(TileIndex tile)
 {
@@ -665,7 +731,7 @@ static void AnimateTile_Industry(TileIndex tile)
 			IndustryGfx gfx = GetIndustryGfx(tile);
 
 			gfx = (gfx < 155) ? gfx + 1 : 148;
-			SetIndustryGfx(tile, gfx);
+			ChangeIndustryTileGfx(tile, gfx);
 			MarkTileDirtyByTile(tile);
 		}
 		break;
@@ -679,12 +745,12 @@ static void AnimateTile_Industry(TileIndex tile)
 
 			byte m = GetAnimationFrame(tile) + 1;
 			if (m == 4 && (m = 0, ++gfx) == GFX_OILWELL_ANIMATED_3 + 1 && (gfx = GFX_OILWELL_ANIMATED_1, b)) {
-				SetIndustryGfx(tile, GFX_OILWELL_NOT_ANIMATED);
+				ChangeIndustryTileGfx(tile, GFX_OILWELL_NOT_ANIMATED);
 				SetIndustryConstructionStage(tile, 3);
 				DeleteAnimatedTile(tile);
 			} else {
 				SetAnimationFrame(tile, m);
-				SetIndustryGfx(tile, gfx);
+				ChangeIndustryTileGfx(tile, gfx);
 				MarkTileDirtyByTile(tile);
 			}
 		}
@@ -842,7 +908,7 @@ static void TileLoop_Industry(TileIndex tile)
 		if (newgfx != INDUSTRYTILE_NOANIM) {
 			ResetIndustryConstructionStage(tile);
 			SetIndustryCompleted(tile);
-			SetIndustryGfx(tile, newgfx);
+			ChangeIndustryTileGfx(tile, newgfx);
 			MarkTileDirtyByTile(tile);
 			return;
 		}
@@ -853,7 +919,7 @@ static void TileLoop_Industry(TileIndex tile)
 	IndustryGfx newgfx = GetIndustryTileSpec(GetIndustryGfx(tile))->anim_next;
 	if (newgfx != INDUSTRYTILE_NOANIM) {
 		ResetIndustryConstructionStage(tile);
-		SetIndustryGfx(tile, newgfx);
+		ChangeIndustryTileGfx(tile, newgfx);
 		MarkTileDirtyByTile(tile);
 		return;
 	}
@@ -869,7 +935,7 @@ static void TileLoop_Industry(TileIndex tile)
 				case GFX_COPPER_MINE_TOWER_NOT_ANIMATED: gfx = GFX_COPPER_MINE_TOWER_ANIMATED; break;
 				case GFX_GOLD_MINE_TOWER_NOT_ANIMATED:   gfx = GFX_GOLD_MINE_TOWER_ANIMATED;   break;
 			}
-			SetIndustryGfx(tile, gfx);
+			ChangeIndustryTileGfx(tile, gfx);
 			SetAnimationFrame(tile, 0x80);
 			AddAnimatedTile(tile);
 		}
@@ -877,7 +943,7 @@ static void TileLoop_Industry(TileIndex tile)
 
 	case GFX_OILWELL_NOT_ANIMATED:
 		if (Chance16(1, 6)) {
-			SetIndustryGfx(tile, GFX_OILWELL_ANIMATED_1);
+			ChangeIndustryTileGfx(tile, GFX_OILWELL_ANIMATED_1);
 			SetAnimationFrame(tile, 0);
 			AddAnimatedTile(tile);
 		}
@@ -892,7 +958,7 @@ static void TileLoop_Industry(TileIndex tile)
 				case GFX_COPPER_MINE_TOWER_ANIMATED: gfx = GFX_COPPER_MINE_TOWER_NOT_ANIMATED; break;
 				case GFX_GOLD_MINE_TOWER_ANIMATED:   gfx = GFX_GOLD_MINE_TOWER_NOT_ANIMATED;   break;
 			}
-			SetIndustryGfx(tile, gfx);
+			ChangeIndustryTileGfx(tile, gfx);
 			SetIndustryCompleted(tile);
 			SetIndustryConstructionStage(tile, 3);
 			DeleteAnimatedTile(tile);
@@ -1133,8 +1199,11 @@ static void ProduceIndustryGoods(Industry *i)
 {
 	const IndustrySpec *indsp = GetIndustrySpec(i->type);
 
+	/* The counter has already been counted down for this tick. */
+	uint16 counter = i->GetCounter();
+
 	/* play a sound? */
-	if ((i->counter & 0x3F) == 0) {
+	if (((counter + 1) & 0x3F) == 0) {
 		uint32 r;
 		if (Chance16R(1, 14, r) && indsp->number_of_sounds != 0 && _settings_client.sound.ambient) {
 			for (size_t j = 0; j < lengthof(i->last_month_production); j++) {
@@ -1149,10 +1218,8 @@ static void ProduceIndustryGoods(Industry *i)
 		}
 	}
 
-	i->counter--;
-
 	/* produce some cargo */
-	if ((i->counter % INDUSTRY_PRODUCE_TICKS) == 0) {
+	if ((counter % INDUSTRY_PRODUCE_TICKS) == 0) {
 		if (HasBit(indsp->callback_mask, CBM_IND_PRODUCTION_256_TICKS)) IndustryProductionCallback(i, 1);
 
 		IndustryBehaviour indbehav = indsp->behaviour;
@@ -1185,7 +1252,7 @@ static void ProduceIndustryGoods(Industry *i)
 			if (cb_res != CALLBACK_FAILED) {
 				cut = ConvertBooleanCallback(indsp->grf_prop.grffile, CBID_INDUSTRY_SPECIAL_EFFECT, cb_res);
 			} else {
-				cut = ((i->counter % INDUSTRY_CUT_TREE_TICKS) == 0);
+				cut = ((counter % INDUSTRY_CUT_TREE_TICKS) == 0);
 			}
 
 			if (cut) ChopLumberMillTrees(i);
@@ -1211,8 +1278,26 @@ void OnTick_Industry()
 
 	if (_game_mode == GM_EDITOR) return;
 
-	for (Industry *i : Industry::Iterate()) {
-		ProduceIndustryGoods(i);
+	/* The counters of all industries count down together, so the industries
+	 * that produce in this tick, or that played a sound every 64 ticks, are
+	 * found from the lowest byte of their counter. They are handled in the
+	 * order of their index, as all random numbers have to be drawn in the
+	 * same order on all clients. */
+	const uint16 clock = ++_industry_tick_clock;
+
+	static std::vector<IndustryID> industries;
+	industries.clear();
+	for (uint offset = 0; offset < INDUSTRY_PRODUCE_TICKS; offset += 0x40) {
+		const std::vector<IndustryID> &slot = _industry_production_schedule[(clock + INDUSTRY_PRODUCE_TICKS - 1 + offset) % INDUSTRY_PRODUCE_TICKS];
+		industries.insert(industries.end(), slot.begin(), slot.end());
+	}
+	const std::vector<IndustryID> &slot = _industry_production_schedule[clock % INDUSTRY_PRODUCE_TICKS];
+	industries.insert(industries.end(), slot.begin(), slot.end());
+
+	std::sort(industries.begin(), industries.end());
+
+	for (IndustryID index : industries) {
+		ProduceIndustryGoods(Industry::Get(index));
 	}
 }
 
@@ -1777,7 +1862,8 @@ static void DoCreateNewIndustry(Industry *i, TileIndex tile, IndustryType type,
 
 	uint16 r = Random();
 	i->random_colour = GB(r, 0, 4);
-	i->counter = GB(r, 4, 12);
+	i->counter = GB(r, 4, 12) + _industry_tick_clock;
+	ScheduleIndustryProduction(i);
 	i->random = initial_random_bits;
 	i->was_cargo_delivered = false;
 	i->last_prod_year = _cur_year;
@@ -1926,6 +2012,7 @@ static void DoCreateNewIndustry(Industry *i, TileIndex tile, IndustryType type,
 		for (uint j = 0; j != 50; j++) PlantRandomFarmField(i);
 	}
 	InvalidateWindowData(WC_INDUSTRY_DIRECTORY, 0, IDIWD_FORCE_REBUILD);
+	InvalidateStationAcceptance(i->location);
 
 	if (!_generating_world) PopulateStationsNearby(i);
 }
@@ -2946,7 +3033,22 @@ void IndustryMonthlyLoop()
 
 	_industry_builder.MonthlyLoop();
 
-	for (Industry *i : Industry::Iterate()) {
+	cur_company.Restore();
+}
+
+/**
+ * Monthly loop for the industries whose index modulo #DAY_TICKS equals the step.
+ * @param step The tick of the first day of the month.
+ */
+void IndustryMonthlyLoopStep(uint step)
+{
+	Backup<CompanyID> cur_company(_current_company, OWNER_NONE, FILE_LINE);
+
+	bool changed = false;
+	for (size_t index = step; index < Industry::GetPoolSize(); index += DAY_TICKS) {
+		Industry *i = Industry::GetIfValid(index);
+		if (i == nullptr) continue;
+
 		UpdateIndustryStatistics(i);
 		if (i->prod_level == PRODLEVEL_CLOSURE) {
 			delete i;
@@ -2954,12 +3056,13 @@ void IndustryMonthlyLoop()
 			ChangeIndustryProduction(i, true);
 			SetWindowDirty(WC_INDUSTRY_VIEW, i->index);
 		}
+		changed = true;
 	}
 
 	cur_company.Restore();
 
 	/* production-change */
-	InvalidateWindowData(WC_INDUSTRY_DIRECTORY, 0, IDIWD_PRODUCTION_CHANGE);
+	if (changed) InvalidateWindowData(WC_INDUSTRY_DIRECTORY, 0, IDIWD_PRODUCTION_CHANGE);
 }
 
 
@@ -2968,6 +3071,9 @@ void InitializeIndustries()
 	Industry::ResetIndustryCounts();
 	_industry_sound_tile = 0;
 
+	_industry_tick_clock = 0;
+	for (auto &slot : _industry_production_schedule) slot.clear();
+
 	_industry_builder.Reset();
 }
 
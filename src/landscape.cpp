@@ -32,6 +32,7 @@
 #include "saveload/saveload.h"
 #include "framerate_type.h"
 #include "landscape_cmd.h"
+#include "newgrf.h"
 #include <array>
 #include <list>
 #include <set>
@@ -790,6 +791,16 @@ std::tuple<CommandCost, Money> CmdClearArea(DoCommandFlag flags, TileIndex tile,
 
 
 TileIndex _cur_tileloop_tile;
+static TileLoopStatistics _tile_loop_stats; ///< Statistics of the tiles visited by RunTileLoop().
+
+/**
+ * Get the statistics of the tile loop.
+ * @return How many tiles the tile loop visited and how many of those were skipped as inert.
+ */
+TileLoopStatistics GetTileLoopStatistics()
+{
+	return _tile_loop_stats;
+}
 
 /**
  * Gradually iterate over all tiles on the map, calling their TileLoopProcs once every 256 ticks.
@@ -823,8 +834,16 @@ void RunTileLoop()
 		count--;
 	}
 
+	/* Inert tiles only need their tile loop for the ambient sound callback, which draws random numbers. */
+	const bool skip_inert = !HasGrfMiscBit(GMB_AMBIENT_SOUND_CALLBACK);
+	_tile_loop_stats.tiles += count;
+
 	while (count--) {
-		_tile_type_procs[tile_map.get(tile).type]->tile_loop_proc(tile);
+		if (skip_inert && tile_map.inert_tiles[tile]) {
+			_tile_loop_stats.skipped++;
+		} else {
+			_tile_type_procs[tile_map.get(tile).type]->tile_loop_proc(tile);
+		}
 
 		/* Get the next tile in sequence using a Galois LFSR. */
 		tile = (tile >> 1) ^ (-(int32)(tile & 1) & feedback);
@@ -33,6 +33,14 @@ byte HighestSnowLine();
 byte LowestSnowLine();
 void ClearSnowLine();
 
+/** Statistics of the tile loop, for the frame rate window. */
+struct TileLoopStatistics {
+	uint64 tiles;   ///< Number of tiles visited by the tile loop.
+	uint64 skipped; ///< Number of visited tiles whose tile loop was skipped as they are inert.
+};
+
+TileLoopStatistics GetTileLoopStatistics();
+
 int GetSlopeZInCorner(Slope tileh, Corner corner);
 Slope GetFoundationSlope(TileIndex tile, int *z = nullptr);
 
@@ -124,11 +124,12 @@ LinkGraphJob::~LinkGraphJob()
 		FlowStatMap &flows = from.Flows();
 
 		for (EdgeIterator it(from.Begin()); it != from.End(); ++it) {
-			if (from[it->first].Flow() == 0) continue;
+			if (it->second.Flow() == 0) continue;
 			StationID to = (*this)[it->first].Station();
 			Station *st2 = Station::GetIfValid(to);
 			if (st2 == nullptr || st2->goods[this->Cargo()].link_graph != this->link_graph.index ||
 					st2->goods[this->Cargo()].node != it->first ||
+					!(*lg)[node_id].HasEdgeTo(it->first) ||
 					(*lg)[node_id][it->first].LastUpdate() == INVALID_DATE) {
 				/* Edge has been removed. Delete flows. */
 				StationIDStack erased = flows.DeleteFlows(to);
@@ -181,12 +182,11 @@ void LinkGraphJob::Init()
 {
 	uint size = this->Size();
 	this->nodes.resize(size);
-	this->edges.Resize(size, size);
 	for (uint i = 0; i < size; ++i) {
-		this->nodes[i].Init(this->link_graph[i].Supply());
-		EdgeAnnotation *node_edges = this->edges[i];
-		for (uint j = 0; j < size; ++j) {
-			node_edges[j].Init();
+		LinkGraph::ConstNode node = this->link_graph[i];
+		this->nodes[i].Init(node.Supply(), node.NumEdges());
+		for (EdgeAnnotation &edge : this->nodes[i].edges) {
+			edge.Init();
 		}
 	}
 }
@@ -196,21 +196,18 @@ void LinkGraphJob::Init()
  */
 void LinkGraphJob::EdgeAnnotation::Init()
 {
-	this->demand = 0;
 	this->flow = 0;
-	this->unsatisfied_demand = 0;
 }
 
 /**
- * Initialize a Linkgraph job node. The underlying memory is expected to be
- * freshly allocated, without any constructors having been called.
+ * Initialize a Linkgraph job node.
  * @param supply Initial undelivered supply.
+ * @param num_edges Number of outgoing edges of the node.
  */
-void LinkGraphJob::NodeAnnotation::Init(uint supply)
+void LinkGraphJob::NodeAnnotation::Init(uint supply, size_t num_edges)
 {
 	this->undelivered_supply = supply;
-	new (&this->flows) FlowStatMap;
-	new (&this->paths) PathList;
+	this->edges.resize(num_edges);
 }
 
 /**
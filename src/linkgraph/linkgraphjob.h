@@ -28,29 +28,59 @@ extern LinkGraphJobPool _link_graph_job_pool;
  * Class for calculation jobs to be run on link graphs.
  */
 class LinkGraphJob : public LinkGraphJobPool::PoolItem<&_link_graph_job_pool>{
+public:
+	/**
+	 * Transport demand from a node to another one. Only kept for the pairs of
+	 * nodes that actually got some demand assigned.
+	 */
+	struct DemandAnnotation {
+		NodeID dest;             ///< Node the demand is to.
+		uint demand;             ///< Transport demand between the nodes.
+		uint unsatisfied_demand; ///< Demand that hasn't been satisfied by flows, yet.
+
+		/**
+		 * Create an empty demand.
+		 * @param dest Node the demand is to.
+		 */
+		DemandAnnotation(NodeID dest) : dest(dest), demand(0), unsatisfied_demand(0) {}
+
+		/**
+		 * Satisfy some demand.
+		 * @param demand Demand to be satisfied.
+		 */
+		void SatisfyDemand(uint demand)
+		{
+			assert(demand <= this->unsatisfied_demand);
+			this->unsatisfied_demand -= demand;
+		}
+	};
+
+	typedef std::vector<DemandAnnotation> DemandAnnotationVector;
+
 private:
 	/**
 	 * Annotation for a link graph edge.
 	 */
 	struct EdgeAnnotation {
-		uint demand;             ///< Transport demand between the nodes.
-		uint unsatisfied_demand; ///< Demand over this edge that hasn't been satisfied yet.
 		uint flow;               ///< Planned flow over this edge.
 		void Init();
 	};
 
+	typedef std::vector<EdgeAnnotation> EdgeAnnotationVector;
+
 	/**
 	 * Annotation for a link graph node.
 	 */
 	struct NodeAnnotation {
-		uint undelivered_supply; ///< Amount of supply that hasn't been distributed yet.
-		PathList paths;          ///< Paths through this node, sorted so that those with flow == 0 are in the back.
-		FlowStatMap flows;       ///< Planned flows to other nodes.
-		void Init(uint supply);
+		uint undelivered_supply;        ///< Amount of supply that hasn't been distributed yet.
+		PathList paths;                 ///< Paths through this node, sorted so that those with flow == 0 are in the back.
+		FlowStatMap flows;              ///< Planned flows to other nodes.
+		EdgeAnnotationVector edges;     ///< Annotations for the outgoing edges, in the same order as the edges of the node.
+		DemandAnnotationVector demands; ///< Demands to other nodes, sorted by destination.
+		void Init(uint supply, size_t num_edges);
 	};
 
 	typedef std::vector<NodeAnnotation> NodeAnnotationVector;
-	typedef SmallMatrix<EdgeAnnotation> EdgeAnnotationMatrix;
 
 	friend SaveLoadTable GetLinkGraphJobDesc();
 	friend class LinkGraphSchedule;
@@ -60,8 +90,7 @@ protected:
 	const LinkGraphSettings settings; ///< Copy of _settings_game.linkgraph at spawn time.
 	std::thread thread;               ///< Thread the job is running in or a default-constructed thread if it's running in the main thread.
 	Date join_date;                   ///< Date when the job is to be joined.
-	NodeAnnotationVector nodes;       ///< Extra node data necessary for link graph calculation.
-	EdgeAnnotationMatrix edges;       ///< Extra edge data necessary for link graph calculation.
+	NodeAnnotationVector nodes;       ///< Extra node and edge data necessary for link graph calculation.
 	std::atomic<bool> job_completed;  ///< Is the job still running. This is accessed by multiple threads and reads may be stale.
 	std::atomic<bool> job_aborted;    ///< Has the job been aborted. This is accessed by multiple threads and reads may be stale.
 
@@ -87,18 +116,6 @@ public:
 		Edge(const LinkGraph::BaseEdge &edge, EdgeAnnotation &anno) :
 				LinkGraph::ConstEdge(edge), anno(anno) {}
 
-		/**
-		 * Get the transport demand between end the points of the edge.
-		 * @return Demand.
-		 */
-		uint Demand() const { return this->anno.demand; }
-
-		/**
-		 * Get the transport demand that hasn't been satisfied by flows, yet.
-		 * @return Unsatisfied demand.
-		 */
-		uint UnsatisfiedDemand() const { return this->anno.unsatisfied_demand; }
-
 		/**
 		 * Get the total flow on the edge.
 		 * @return Flow.
@@ -120,26 +137,6 @@ public:
 			assert(flow <= this->anno.flow);
 			this->anno.flow -= flow;
 		}
-
-		/**
-		 * Add some (not yet satisfied) demand.
-		 * @param demand Demand to be added.
-		 */
-		void AddDemand(uint demand)
-		{
-			this->anno.demand += demand;
-			this->anno.unsatisfied_demand += demand;
-		}
-
-		/**
-		 * Satisfy some demand.
-		 * @param demand Demand to be satisfied.
-		 */
-		void SatisfyDemand(uint demand)
-		{
-			assert(demand <= this->anno.unsatisfied_demand);
-			this->anno.unsatisfied_demand -= demand;
-		}
 	};
 
 	/**
@@ -154,7 +151,7 @@ public:
 		 * @param base_anno Array of annotations to be iterated.
 		 * @param current Start offset of iteration.
 		 */
-		EdgeIterator(const LinkGraph::BaseEdge *base, EdgeAnnotation *base_anno, NodeID current) :
+		EdgeIterator(const LinkGraph::BaseEdge *base, EdgeAnnotation *base_anno, size_t current) :
 				LinkGraph::BaseEdgeIterator<const LinkGraph::BaseEdge, Edge, EdgeIterator>(base, current),
 				base_anno(base_anno) {}
 
@@ -165,7 +162,7 @@ public:
 		 */
 		std::pair<NodeID, Edge> operator*() const
 		{
-			return std::pair<NodeID, Edge>(this->current, Edge(this->base[this->current], this->base_anno[this->current]));
+			return std::pair<NodeID, Edge>(this->base[this->current].dest_node, Edge(this->base[this->current], this->base_anno[this->current]));
 		}
 
 		/**
@@ -185,7 +182,6 @@ public:
 	class Node : public LinkGraph::ConstNode {
 	private:
 		NodeAnnotation &node_anno;  ///< Annotation being wrapped.
-		EdgeAnnotation *edge_annos; ///< Edge annotations belonging to this node.
 	public:
 
 		/**
@@ -195,30 +191,32 @@ public:
 		 */
 		Node (LinkGraphJob *lgj, NodeID node) :
 			LinkGraph::ConstNode(&lgj->link_graph, node),
-			node_anno(lgj->nodes[node]), edge_annos(lgj->edges[node])
+			node_anno(lgj->nodes[node])
 		{}
 
 		/**
 		 * Retrieve an edge starting at this node. Mind that this returns an
-		 * object, not a reference.
+		 * object, not a reference. The edge has to exist.
 		 * @param to Remote end of the edge.
 		 * @return Edge between this node and "to".
 		 */
-		Edge operator[](NodeID to) const { return Edge(this->edges[to], this->edge_annos[to]); }
+		Edge operator[](NodeID to) const
+		{
+			size_t edge = this->FindEdge(to);
+			return Edge(this->node.edges[edge], this->node_anno.edges[edge]);
+		}
 
 		/**
-		 * Iterator for the "begin" of the edge array. Only edges with capacity
-		 * are iterated. The others are skipped.
+		 * Iterator for the "begin" of the edge array.
 		 * @return Iterator pointing to the first edge.
 		 */
-		EdgeIterator Begin() const { return EdgeIterator(this->edges, this->edge_annos, index); }
+		EdgeIterator Begin() const { return EdgeIterator(this->node.edges.data(), this->node_anno.edges.data(), 0); }
 
 		/**
-		 * Iterator for the "end" of the edge array. Only edges with capacity
-		 * are iterated. The others are skipped.
+		 * Iterator for the "end" of the edge array.
 		 * @return Iterator pointing beyond the last edge.
 		 */
-		EdgeIterator End() const { return EdgeIterator(this->edges, this->edge_annos, INVALID_NODE); }
+		EdgeIterator End() const { return EdgeIterator(this->node.edges.data(), this->node_anno.edges.data(), this->node.edges.size()); }
 
 		/**
 		 * Get amount of supply that hasn't been delivered, yet.
@@ -252,14 +250,28 @@ public:
 		const PathList &Paths() const { return this->node_anno.paths; }
 
 		/**
-		 * Deliver some supply, adding demand to the respective edge.
+		 * Get the demands from this node to other nodes, sorted by
+		 * destination. Nodes this one has no demand to are not listed.
+		 * @return Demands.
+		 */
+		DemandAnnotationVector &Demands() { return this->node_anno.demands; }
+
+		/**
+		 * Deliver some supply, adding demand to the respective destination.
 		 * @param to Destination for supply.
 		 * @param amount Amount of supply to be delivered.
 		 */
 		void DeliverSupply(NodeID to, uint amount)
 		{
 			this->node_anno.undelivered_supply -= amount;
-			(*this)[to].AddDemand(amount);
+			if (amount == 0) return;
+
+			DemandAnnotationVector &demands = this->node_anno.demands;
+			auto it = std::lower_bound(demands.begin(), demands.end(), to,
+					[](const DemandAnnotation &demand, NodeID to) { return demand.dest < to; });
+			if (it == demands.end() || it->dest != to) it = demands.emplace(it, to);
+			it->demand += amount;
+			it->unsatisfied_demand += amount;
 		}
 	};
 
@@ -2,6 +2,7 @@
 
 #include "../stdafx.h"
 #include "../core/math_func.hpp"
+#include "../thread_pool.h"
 #include "mcf.h"
 #include <set>
 
@@ -9,6 +10,13 @@
 
 typedef std::map<NodeID, Path *> PathViaMap;
 
+/**
+ * Number of sources whose paths are searched at the same time. All searches of
+ * a batch see the flows assigned before the batch, so the result depends on
+ * this number, but not on the number of threads doing the searches.
+ */
+static const uint MCF_BATCH_SIZE = 64;
+
 /**
  * Distance-based annotation for use in the Dijkstra algorithm. This is close
  * to the original meaning of "annotation" in this context. Paths are rated
@@ -88,8 +96,8 @@ public:
 };
 
 /**
- * Iterator class for getting the edges in the order of their next_edge
- * members.
+ * Iterator class for getting the edges of a node in the order of their
+ * destinations.
  */
 class GraphEdgeIterator {
 private:
@@ -104,7 +112,7 @@ public:
 	 * @param job Job to iterate on.
 	 */
 	GraphEdgeIterator(LinkGraphJob &job) : job(job),
-		i(nullptr, nullptr, INVALID_NODE), end(nullptr, nullptr, INVALID_NODE)
+		i(nullptr, nullptr, 0), end(nullptr, nullptr, 0)
 	{}
 
 	/**
@@ -306,6 +314,25 @@ void MultiCommodityFlow::Dijkstra(NodeID source_node, PathVector &paths)
 	}
 }
 
+/**
+ * Run the Dijkstra algorithm for a batch of sources, spread over the worker
+ * threads. The searches only read the job, so they don't interfere.
+ * @tparam Tannotation Annotation to be used.
+ * @tparam Tedge_iterator Iterator to be used for getting outgoing edges.
+ * @param first First source node of the batch.
+ * @param last Node after the last source node of the batch.
+ * @param finished_sources Sources to skip.
+ * @param paths Container for the paths of each source, indexed from \a first.
+ */
+template<class Tannotation, class Tedge_iterator>
+void MultiCommodityFlow::Dijkstra(NodeID first, NodeID last, const std::vector<bool> &finished_sources, std::vector<PathVector> &paths)
+{
+	ParallelFor(last - first, [&](uint i) {
+		NodeID source = first + i;
+		if (!finished_sources[source]) this->Dijkstra<Tannotation, Tedge_iterator>(source, paths[i]);
+	});
+}
+
 /**
  * Clean up paths that lead nowhere and the root path.
  * @param source_id ID of the root node.
@@ -335,20 +362,20 @@ void MultiCommodityFlow::CleanupPaths(NodeID source_id, PathVector &paths)
 
 /**
  * Push flow along a path and update the unsatisfied_demand of the associated
- * edge.
- * @param edge Edge whose ends the path connects.
+ * demand.
+ * @param demand Demand between the ends of the path.
  * @param path End of the path the flow should be pushed on.
  * @param accuracy Accuracy of the calculation.
  * @param max_saturation If < UINT_MAX only push flow up to the given
  *                       saturation, otherwise the path can be "overloaded".
  */
-uint MultiCommodityFlow::PushFlow(Edge &edge, Path *path, uint accuracy,
+uint MultiCommodityFlow::PushFlow(DemandAnnotation &demand, Path *path, uint accuracy,
 		uint max_saturation)
 {
-	assert(edge.UnsatisfiedDemand() > 0);
-	uint flow = Clamp(edge.Demand() / accuracy, 1, edge.UnsatisfiedDemand());
+	assert(demand.unsatisfied_demand > 0);
+	uint flow = Clamp(demand.demand / accuracy, 1, demand.unsatisfied_demand);
 	flow = path->AddFlow(flow, this->job, max_saturation);
-	edge.SatisfyDemand(flow);
+	demand.SatisfyDemand(flow);
 	return flow;
 }
 
@@ -499,7 +526,7 @@ bool MCF1stPass::EliminateCycles()
  */
 MCF1stPass::MCF1stPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 {
-	PathVector paths;
+	std::vector<PathVector> batch_paths(MCF_BATCH_SIZE);
 	uint16 size = job.Size();
 	uint accuracy = job.Settings().accuracy;
 	bool more_loops;
@@ -507,35 +534,40 @@ MCF1stPass::MCF1stPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 
 	do {
 		more_loops = false;
-		for (NodeID source = 0; source < size; ++source) {
-			if (finished_sources[source]) continue;
+		for (uint first = 0; first < size; first += MCF_BATCH_SIZE) {
+			uint last = std::min<uint>(first + MCF_BATCH_SIZE, size);
 
 			/* First saturate the shortest paths. */
-			this->Dijkstra<DistanceAnnotation, GraphEdgeIterator>(source, paths);
-
-			bool source_demand_left = false;
-			for (NodeID dest = 0; dest < size; ++dest) {
-				Edge edge = job[source][dest];
-				if (edge.UnsatisfiedDemand() > 0) {
-					Path *path = paths[dest];
-					assert(path != nullptr);
-					/* Generally only allow paths that don't exceed the
-					 * available capacity. But if no demand has been assigned
-					 * yet, make an exception and allow any valid path *once*. */
-					if (path->GetFreeCapacity() > 0 && this->PushFlow(edge, path,
-							accuracy, this->max_saturation) > 0) {
-						/* If a path has been found there is a chance we can
-						 * find more. */
-						more_loops = more_loops || (edge.UnsatisfiedDemand() > 0);
-					} else if (edge.UnsatisfiedDemand() == edge.Demand() &&
-							path->GetFreeCapacity() > INT_MIN) {
-						this->PushFlow(edge, path, accuracy, UINT_MAX);
+			this->Dijkstra<DistanceAnnotation, GraphEdgeIterator>(first, last, finished_sources, batch_paths);
+
+			/* Assign the flows in source order, independent of which thread found the paths. */
+			for (NodeID source = first; source < last; ++source) {
+				if (finished_sources[source]) continue;
+
+				PathVector &paths = batch_paths[source - first];
+				bool source_demand_left = false;
+				for (DemandAnnotation &demand : job[source].Demands()) {
+					if (demand.unsatisfied_demand > 0) {
+						Path *path = paths[demand.dest];
+						assert(path != nullptr);
+						/* Generally only allow paths that don't exceed the
+						 * available capacity. But if no demand has been assigned
+						 * yet, make an exception and allow any valid path *once*. */
+						if (path->GetFreeCapacity() > 0 && this->PushFlow(demand, path,
+								accuracy, this->max_saturation) > 0) {
+							/* If a path has been found there is a chance we can
+							 * find more. */
+							more_loops = more_loops || (demand.unsatisfied_demand > 0);
+						} else if (demand.unsatisfied_demand == demand.demand &&
+								path->GetFreeCapacity() > INT_MIN) {
+							this->PushFlow(demand, path, accuracy, UINT_MAX);
+						}
+						if (demand.unsatisfied_demand > 0) source_demand_left = true;
 					}
-					if (edge.UnsatisfiedDemand() > 0) source_demand_left = true;
 				}
+				finished_sources[source] = !source_demand_left;
+				this->CleanupPaths(source, paths);
 			}
-			finished_sources[source] = !source_demand_left;
-			this->CleanupPaths(source, paths);
 		}
 	} while ((more_loops || this->EliminateCycles()) && !job.IsJobAborted());
 }
@@ -548,32 +580,37 @@ MCF1stPass::MCF1stPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 MCF2ndPass::MCF2ndPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 {
 	this->max_saturation = UINT_MAX; // disable artificial cap on saturation
-	PathVector paths;
+	std::vector<PathVector> batch_paths(MCF_BATCH_SIZE);
 	uint16 size = job.Size();
 	uint accuracy = job.Settings().accuracy;
 	bool demand_left = true;
 	std::vector<bool> finished_sources(size);
 	while (demand_left && !job.IsJobAborted()) {
 		demand_left = false;
-		for (NodeID source = 0; source < size; ++source) {
-			if (finished_sources[source]) continue;
-
-			this->Dijkstra<CapacityAnnotation, FlowEdgeIterator>(source, paths);
-
-			bool source_demand_left = false;
-			for (NodeID dest = 0; dest < size; ++dest) {
-				Edge edge = this->job[source][dest];
-				Path *path = paths[dest];
-				if (edge.UnsatisfiedDemand() > 0 && path->GetFreeCapacity() > INT_MIN) {
-					this->PushFlow(edge, path, accuracy, UINT_MAX);
-					if (edge.UnsatisfiedDemand() > 0) {
-						demand_left = true;
-						source_demand_left = true;
+		for (uint first = 0; first < size; first += MCF_BATCH_SIZE) {
+			uint last = std::min<uint>(first + MCF_BATCH_SIZE, size);
+
+			this->Dijkstra<CapacityAnnotation, FlowEdgeIterator>(first, last, finished_sources, batch_paths);
+
+			/* Assign the flows in source order, independent of which thread found the paths. */
+			for (NodeID source = first; source < last; ++source) {
+				if (finished_sources[source]) continue;
+
+				PathVector &paths = batch_paths[source - first];
+				bool source_demand_left = false;
+				for (DemandAnnotation &demand : this->job[source].Demands()) {
+					Path *path = paths[demand.dest];
+					if (demand.unsatisfied_demand > 0 && path->GetFreeCapacity() > INT_MIN) {
+						this->PushFlow(demand, path, accuracy, UINT_MAX);
+						if (demand.unsatisfied_demand > 0) {
+							demand_left = true;
+							source_demand_left = true;
+						}
 					}
 				}
+				finished_sources[source] = !source_demand_left;
+				this->CleanupPaths(source, paths);
 			}
-			finished_sources[source] = !source_demand_left;
-			this->CleanupPaths(source, paths);
 		}
 	}
 }
@@ -24,7 +24,10 @@ protected:
 	template<class Tannotation, class Tedge_iterator>
 	void Dijkstra(NodeID from, PathVector &paths);
 
-	uint PushFlow(Edge &edge, Path *path, uint accuracy, uint max_saturation);
+	template<class Tannotation, class Tedge_iterator>
+	void Dijkstra(NodeID first, NodeID last, const std::vector<bool> &finished_sources, std::vector<PathVector> &paths);
+
+	uint PushFlow(DemandAnnotation &demand, Path *path, uint accuracy, uint max_saturation);
 
 	void CleanupPaths(NodeID source, PathVector &paths);
 
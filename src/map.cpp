@@ -27,6 +27,7 @@ void TileMap::Allocate()
 	free(_m);
 
 	_m = CallocT<Tile>(size);
+	inert_tiles.assign(size, false);
 }
 
 /**
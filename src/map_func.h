@@ -15,6 +15,7 @@
 #include "map_type.h"
 #include "direction_func.h"
 #include "company_type.h"
+#include <vector>
 
 
 struct TileMap
@@ -38,6 +39,15 @@ struct TileMap
 	 */
 	Tile* _m = nullptr;
 
+	/**
+	 * Tiles whose tile loop is known to do nothing, so RunTileLoop() can skip them.
+	 * The tile loop procs mark their tile when it has nothing left to do; whatever
+	 * changes the state their decision depends on must clear the mark again. As the
+	 * decision may depend on the type of the neighbouring tiles, changing the type
+	 * of a tile clears the marks around it.
+	 */
+	std::vector<bool> inert_tiles;
+
 	void Allocate();
 
 	TileIndex tile(uint x, uint y)
@@ -49,6 +59,16 @@ struct TileMap
 	{
 		assert(i < size);
 		_m[i].type = type;
+
+		/* The tile and its neighbours might have something to do in their tile loop now. */
+		uint x = i.value & (size_x - 1);
+		uint y = i.value >> log_x;
+		for (uint ny = std::max(y, 1U) - 1; ny <= std::min(y + 1, size_y - 1); ny++) {
+			for (uint nx = std::max(x, 1U) - 1; nx <= std::min(x + 1, size_x - 1); nx++) {
+				inert_tiles[(ny << log_x) + nx] = false;
+			}
+		}
+
 		return _m[i];
 	}
 
@@ -9504,7 +9504,9 @@ void LoadNewGRFFile(GRFConfig *config, GrfLoadingStage stage, Subdirectory subdi
 		SpriteFile temporarySpriteFile(filename, subdir, needs_palette_remap);
 		LoadNewGRFFileFromFile(config, stage, temporarySpriteFile);
 	} else {
-		LoadNewGRFFileFromFile(config, stage, OpenCachedSpriteFile(filename, subdir, needs_palette_remap));
+		SpriteFile &file = OpenCachedSpriteFile(filename, subdir, needs_palette_remap);
+		file.SetMD5Sum(config->ident.md5sum);
+		LoadNewGRFFileFromFile(config, stage, file);
 	}
 }
 
@@ -53,7 +53,18 @@ struct AnimationBase {
 		 * increasing this value by one doubles the wait. 0 is the minimum value
 		 * allowed for animation_speed, which corresponds to 30ms, and 16 is the
 		 * maximum, corresponding to around 33 minutes. */
-		if (_tick_counter % (1ULL << animation_speed) != 0) return;
+		uint64 period = 1ULL << animation_speed;
+
+		/* Without the speed callback the speed cannot change, so until the
+		 * next multiple of the period the tile would only return here. Moving
+		 * the tile to the timing wheel costs more than returning here once, so
+		 * fast animations and tiles that are due next tick stay awake. */
+		if (!HasBit(spec->callback_mask, Tbase::cbm_animation_speed) && period > 2) {
+			uint64 wake = (_tick_counter / period + 1) * period;
+			if (wake > _tick_counter + 1) SetAnimatedTileWakeUp(tile, wake);
+		}
+
+		if (_tick_counter % period != 0) return;
 
 		uint8 frame      = GetAnimationFrame(tile);
 		uint8 num_frames = spec->animation.frames;
@@ -26,6 +26,9 @@
 
 #include "fileio_func.h"
 #include "fios.h"
+#include "thread_pool.h"
+
+#include <sys/stat.h>
 
 #include "safeguards.h"
 
@@ -359,13 +362,13 @@ static bool CalcGRFMD5Sum(GRFConfig *config, Subdirectory subdir)
 
 
 /**
- * Find the GRFID of a given grf, and calculate its md5sum.
+ * Find the GRFID and the other Action 8 and 14 information of a given grf.
  * @param config    grf to fill.
  * @param is_static grf is static.
  * @param subdir    the subdirectory to search in.
- * @return Operation was successfully completed.
+ * @return Whether the grf is usable, i.e. whether its md5sum has to be determined.
  */
-bool FillGRFDetails(GRFConfig *config, bool is_static, Subdirectory subdir)
+static bool ReadGRFDetails(GRFConfig *config, bool is_static, Subdirectory subdir)
 {
 	if (!FioCheckFileExists(config->filename, subdir)) {
 		config->status = GCS_NOT_FOUND;
@@ -388,7 +391,19 @@ bool FillGRFDetails(GRFConfig *config, bool is_static, Subdirectory subdir)
 		if (HasBit(config->flags, GCF_UNSAFE)) return false;
 	}
 
-	return CalcGRFMD5Sum(config, subdir);
+	return true;
+}
+
+/**
+ * Find the GRFID of a given grf, and calculate its md5sum.
+ * @param config    grf to fill.
+ * @param is_static grf is static.
+ * @param subdir    the subdirectory to search in.
+ * @return Operation was successfully completed.
+ */
+bool FillGRFDetails(GRFConfig *config, bool is_static, Subdirectory subdir)
+{
+	return ReadGRFDetails(config, is_static, subdir) && CalcGRFMD5Sum(config, subdir);
 }
 
 
@@ -579,10 +594,147 @@ compatible_grf:
 /** Set this flag to prevent any NewGRF scanning from being done. */
 int _skip_all_newgrf_scanning = 0;
 
-/** Helper for scanning for files with GRF as extension */
+/** Cached md5sum of a scanned GRF, valid as long as the file keeps its size and modification time. */
+struct GRFScanCacheEntry {
+	uint64 size;       ///< Size of the file.
+	int64 mtime;       ///< Modification time of the file.
+	uint8 md5sum[16];  ///< MD5 checksum of the file.
+};
+
+/** Cached md5sums of the scanned GRFs, by their full path. */
+typedef std::map<std::string, GRFScanCacheEntry> GRFScanCache;
+
+/** Header of the file with the GRF scan cache. */
+static const char * const GRF_SCAN_CACHE_HEADER = "OpenTTD NewGRF scan cache 1";
+
+/**
+ * Get the name of the file the GRF scan cache is stored in.
+ * @return The filename, or an empty string when there is no personal directory.
+ */
+static std::string GetGRFScanCacheFilename()
+{
+	if (_personal_dir.empty()) return {};
+	return _personal_dir + "cache" PATHSEP "newgrf_scan.dat";
+}
+
+/**
+ * Load the GRF scan cache of the previous scan.
+ * @param[out] cache The cache to fill.
+ */
+static void LoadGRFScanCache(GRFScanCache &cache)
+{
+	std::string filename = GetGRFScanCacheFilename();
+	if (filename.empty()) return;
+
+	FILE *f = FioFOpenFile(filename, "rb", NO_DIRECTORY);
+	if (f == nullptr) return;
+
+	char line[MAX_PATH + 128];
+	if (fgets(line, sizeof(line), f) != nullptr && strncmp(line, GRF_SCAN_CACHE_HEADER, strlen(GRF_SCAN_CACHE_HEADER)) == 0) {
+		/* Each line holds: <md5sum> <size> <mtime> <path> */
+		while (fgets(line, sizeof(line), f) != nullptr) {
+			size_t len = strlen(line);
+			if (len == 0 || line[len - 1] != '\n') break;
+			line[len - 1] = '\0';
+
+			GRFScanCacheEntry entry;
+			char *p = line;
+			bool valid = true;
+			for (uint i = 0; i < lengthof(entry.md5sum) && valid; i++) {
+				char hex[3] = { p[0], p[0] != '\0' ? p[1] : '\0', '\0' };
+				char *end;
+				entry.md5sum[i] = (uint8)strtoul(hex, &end, 16);
+				valid = end == hex + 2;
+				p += 2;
+			}
+			if (!valid || *p != ' ') continue;
+			entry.size = strtoull(p, &p, 10);
+			if (*p != ' ') continue;
+			entry.mtime = strtoll(p, &p, 10);
+			if (*p != ' ' || p[1] == '\0') continue;
+
+			cache[p + 1] = entry;
+		}
+	}
+
+	FioFCloseFile(f);
+}
+
+/**
+ * Save the GRF scan cache for the next scan.
+ * @param cache The cache to save.
+ */
+static void SaveGRFScanCache(const GRFScanCache &cache)
+{
+	std::string filename = GetGRFScanCacheFilename();
+	if (filename.empty()) return;
+
+	FioCreateDirectory(_personal_dir + "cache");
+	FILE *f = FioFOpenFile(filename, "wb", NO_DIRECTORY);
+	if (f == nullptr) return;
+
+	fprintf(f, "%s\n", GRF_SCAN_CACHE_HEADER);
+	for (const auto &it : cache) {
+		char md5sum[33];
+		md5sumToString(md5sum, lastof(md5sum), it.second.md5sum);
+		std::string line = fmt::format("{} {} {} {}\n", md5sum, it.second.size, it.second.mtime, it.first);
+		fwrite(line.data(), 1, line.size(), f);
+	}
+
+	FioFCloseFile(f);
+}
+
+/**
+ * Get the size and modification time of a file.
+ * @param filename The full path of the file.
+ * @param[out] size The size of the file.
+ * @param[out] mtime The modification time of the file.
+ * @return Whether the file could be accessed.
+ */
+static bool GetGRFFileStat(const std::string &filename, uint64 &size, int64 &mtime)
+{
+#ifdef _WIN32
+	struct _stat64 sb;
+	if (_wstat64(OTTD2FS(filename).c_str(), &sb) != 0) return false;
+#else
+	struct stat sb;
+	if (stat(OTTD2FS(filename).c_str(), &sb) != 0) return false;
+#endif
+	size = sb.st_size;
+	mtime = sb.st_mtime;
+	return true;
+}
+
+/**
+ * Helper for scanning for files with GRF as extension.
+ * The files are first collected, and then processed in batches: the GRF
+ * information is read one by one as the NewGRF loader is not reentrant,
+ * after which the md5sums of the batch are calculated on all cores, unless
+ * they are known from the scan cache.
+ */
 class GRFFileScanner : FileScanner {
+	/** A found GRF file. */
+	struct File {
+		std::string filename;      ///< Full path of the file.
+		size_t basepath_length;    ///< Length of the search path in #filename.
+		std::string tar_filename;  ///< The tar the file is in, if any.
+	};
+
+	/** A GRF file of the batch being processed. */
+	struct Item {
+		GRFConfig *config;        ///< The GRF, or \c nullptr if it is not usable.
+		const File *file;         ///< The file of the GRF.
+		GRFScanCacheEntry entry;  ///< Size, modification time and md5sum of the file.
+		bool valid;               ///< Whether the md5sum is known.
+		bool cacheable;           ///< Whether the size and modification time are known.
+	};
+
 	std::chrono::steady_clock::time_point next_update; ///< The next moment we do update the screen.
 	uint num_scanned; ///< The number of GRFs we have scanned.
+	std::vector<File> files; ///< The found GRF files.
+
+	bool AddGRF(GRFConfig *c);
+	uint ProcessFiles();
 
 public:
 	GRFFileScanner() : num_scanned(0)
@@ -601,7 +753,8 @@ public:
 		}
 
 		GRFFileScanner fs;
-		int ret = fs.Scan(".grf", NEWGRF_DIR);
+		fs.Scan(".grf", NEWGRF_DIR);
+		int ret = fs.ProcessFiles();
 		/* The number scanned and the number returned may not be the same;
 		 * duplicate NewGRFs and base sets are ignored in the return value. */
 		_settings_client.gui.last_newgrf_count = fs.num_scanned;
@@ -611,55 +764,122 @@ public:
 
 bool GRFFileScanner::AddFile(const std::string &filename, size_t basepath_length, const std::string &tar_filename)
 {
-	/* Abort if the user stopped the game during a scan. */
-	if (_exit_game) return false;
+	this->files.push_back({ filename, basepath_length, tar_filename });
+	return true;
+}
 
-	GRFConfig *c = new GRFConfig(filename.c_str() + basepath_length);
+/**
+ * Add a scanned GRF to the list of all GRFs.
+ * @param c The GRF to add.
+ * @return Whether the GRF was added, i.e. whether it is not yet known.
+ */
+bool GRFFileScanner::AddGRF(GRFConfig *c)
+{
+	if (_all_grfs == nullptr) {
+		_all_grfs = c;
+		return true;
+	}
 
+	/* Insert file into list at a position determined by its
+	 * name, so the list is sorted as we go along */
+	GRFConfig **pd, *d;
 	bool added = true;
-	if (FillGRFDetails(c, false)) {
-		if (_all_grfs == nullptr) {
-			_all_grfs = c;
-		} else {
-			/* Insert file into list at a position determined by its
-			 * name, so the list is sorted as we go along */
-			GRFConfig **pd, *d;
-			bool stop = false;
-			for (pd = &_all_grfs; (d = *pd) != nullptr; pd = &d->next) {
-				if (c->ident.grfid == d->ident.grfid && memcmp(c->ident.md5sum, d->ident.md5sum, sizeof(c->ident.md5sum)) == 0) added = false;
-				/* Because there can be multiple grfs with the same name, make sure we checked all grfs with the same name,
-				 *  before inserting the entry. So insert a new grf at the end of all grfs with the same name, instead of
-				 *  just after the first with the same name. Avoids doubles in the list. */
-				if (strcasecmp(c->GetName(), d->GetName()) <= 0) {
-					stop = true;
-				} else if (stop) {
-					break;
+	bool stop = false;
+	for (pd = &_all_grfs; (d = *pd) != nullptr; pd = &d->next) {
+		if (c->ident.grfid == d->ident.grfid && memcmp(c->ident.md5sum, d->ident.md5sum, sizeof(c->ident.md5sum)) == 0) added = false;
+		/* Because there can be multiple grfs with the same name, make sure we checked all grfs with the same name,
+		 *  before inserting the entry. So insert a new grf at the end of all grfs with the same name, instead of
+		 *  just after the first with the same name. Avoids doubles in the list. */
+		if (strcasecmp(c->GetName(), d->GetName()) <= 0) {
+			stop = true;
+		} else if (stop) {
+			break;
+		}
+	}
+	if (added) {
+		c->next = d;
+		*pd = c;
+	}
+	return added;
+}
+
+/**
+ * Read the information and md5sums of all found GRF files.
+ * @return The number of GRFs that were added to the list of all GRFs.
+ */
+uint GRFFileScanner::ProcessFiles()
+{
+	GRFScanCache cache;
+	LoadGRFScanCache(cache);
+	GRFScanCache new_cache;
+
+	const size_t batch_size = GetWorkerThreadCount() * 4;
+	std::vector<Item> batch;
+	uint num = 0;
+
+	for (size_t first = 0; first < this->files.size(); first += batch_size) {
+		/* Abort if the user stopped the game during a scan. */
+		if (_exit_game) break;
+
+		batch.clear();
+		for (size_t i = first; i < std::min(first + batch_size, this->files.size()); i++) {
+			const File &file = this->files[i];
+			GRFConfig *c = new GRFConfig(file.filename.c_str() + file.basepath_length);
+			if (!ReadGRFDetails(c, false, NEWGRF_DIR)) {
+				delete c;
+				c = nullptr;
+			}
+			batch.push_back({ c, &file, {}, false, false });
+		}
+
+		ParallelFor((uint)batch.size(), [&batch, &cache](uint i) {
+			Item &item = batch[i];
+			if (item.config == nullptr) return;
+
+			const std::string &path = item.file->tar_filename.empty() ? item.file->filename : item.file->tar_filename;
+			item.cacheable = GetGRFFileStat(path, item.entry.size, item.entry.mtime);
+			if (item.cacheable) {
+				auto it = cache.find(item.file->filename);
+				if (it != cache.end() && it->second.size == item.entry.size && it->second.mtime == item.entry.mtime) {
+					MemCpyT(item.config->ident.md5sum, it->second.md5sum, lengthof(item.config->ident.md5sum));
+					item.valid = true;
+					return;
 				}
 			}
-			if (added) {
-				c->next = d;
-				*pd = c;
+
+			if (!CalcGRFMD5Sum(item.config, NEWGRF_DIR)) return;
+			MemCpyT(item.entry.md5sum, item.config->ident.md5sum, lengthof(item.entry.md5sum));
+			item.valid = true;
+		});
+
+		for (Item &item : batch) {
+			GRFConfig *c = item.config;
+			bool added = false;
+			if (c != nullptr && item.valid) {
+				if (item.cacheable) new_cache[item.file->filename] = item.entry;
+				added = this->AddGRF(c);
 			}
-		}
-	} else {
-		added = false;
-	}
+			if (added) num++;
 
-	this->num_scanned++;
+			this->num_scanned++;
 
-	const char *name = nullptr;
-	if (c->name != nullptr) name = GetGRFStringFromGRFText(c->name);
-	if (name == nullptr) name = c->filename;
-	UpdateNewGRFScanStatus(this->num_scanned, name);
-	VideoDriver::GetInstance()->GameLoopPause();
+			const char *name = nullptr;
+			if (c != nullptr && c->name != nullptr) name = GetGRFStringFromGRFText(c->name);
+			if (name == nullptr) name = item.file->filename.c_str() + item.file->basepath_length;
+			UpdateNewGRFScanStatus(this->num_scanned, name);
 
-	if (!added) {
-		/* File couldn't be opened, or is either not a NewGRF or is a
-		 * 'system' NewGRF or it's already known, so forget about it. */
-		delete c;
+			if (!added) {
+				/* File couldn't be opened, or is either not a NewGRF or is a
+				 * 'system' NewGRF or it's already known, so forget about it. */
+				delete c;
+			}
+		}
+		VideoDriver::GetInstance()->GameLoopPause();
 	}
 
-	return added;
+	if (!_exit_game) SaveGRFScanCache(new_cache);
+
+	return num;
 }
 
 /**
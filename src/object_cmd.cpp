@@ -130,6 +130,9 @@ void BuildObject(ObjectType type, TileIndex tile, CompanyID owner, Town *town, u
 		MarkTileDirtyByTile(t);
 	}
 
+	/* Company headquarters accept cargo. */
+	if (type == OBJECT_HQ) InvalidateStationAcceptance(ta);
+
 	Object::IncTypeCount(type);
 	if (spec->flags & OBJECT_FLAG_ANIMATION) TriggerObjectAnimation(o, OAT_BUILT, spec);
 }
@@ -60,6 +60,7 @@
 #include "game/game_config.hpp"
 #include "town.h"
 #include "subsidy_func.h"
+#include "spritecache.h"
 #include "gfx_layout.h"
 #include "viewport_func.h"
 #include "viewport_sprite_sorter.h"
@@ -67,6 +68,7 @@
 #include "industry.h"
 #include "network/network_gui.h"
 #include "misc_cmd.h"
+#include "economy_func.h"
 
 #include "linkgraph/linkgraphschedule.h"
 
@@ -95,6 +97,8 @@ extern std::string _config_file;
 bool _save_config = false;
 bool _request_newgrf_scan = false;
 NewGRFScanCallback *_request_newgrf_scan_callback = nullptr;
+static std::string _export_tiles_dir; ///< Directory to export the map tiles of the loaded game to, before exiting.
+static bool _export_tiles_failed = false; ///< Whether loading the game or exporting its map tiles failed; the game then exits with an error.
 
 /**
  * Error handling for fatal user errors.
@@ -185,6 +189,7 @@ static void ShowHelp()
 		"  -d [[fac=]lvl[,...]]= Debug mode\n"
 		"  -e                  = Start Editor\n"
 		"  -g [savegame]       = Start new/save game immediately\n"
+		"  -T directory        = Export the map tiles of the savegame loaded with -g and exit\n"
 		"  -G seed             = Set random seed\n"
 		"  -n [ip:port#company]= Join network game\n"
 		"  -p password         = Password to join server\n"
@@ -312,6 +317,9 @@ static void ShutdownGame()
 
 	if (_network_available) NetworkShutDown(); // Shut down the network and close any open connections
 
+	/* The sprite prefetch threads use the blitter and the sprite files. */
+	StopSpritePrefetchThreads();
+
 	DriverFactoryBase::ShutdownDrivers();
 
 	UnInitWindowSystem();
@@ -508,6 +516,7 @@ static const OptionData _options[] = {
 	GETOPT_SHORT_OPTVAL('d'),
 	 GETOPT_SHORT_NOVAL('e'),
 	GETOPT_SHORT_OPTVAL('g'),
+	 GETOPT_SHORT_VALUE('T'),
 	 GETOPT_SHORT_VALUE('G'),
 	 GETOPT_SHORT_VALUE('c'),
 	 GETOPT_SHORT_NOVAL('x'),
@@ -615,6 +624,7 @@ int openttd_main(int argc, char *argv[])
 				scanner->generation_seed = InteractiveRandom();
 			}
 			break;
+		case 'T': _export_tiles_dir = mgo.opt; break;
 		case 'q': {
 			DeterminePaths(argv[0], only_local_path);
 			if (StrEmpty(mgo.opt)) {
@@ -659,6 +669,11 @@ int openttd_main(int argc, char *argv[])
 		if (i == -2) break;
 	}
 
+	if (!_export_tiles_dir.empty() && _switch_mode != SM_LOAD_GAME) {
+		fprintf(stderr, "Exporting the map tiles with -T requires a savegame given with -g\n");
+		return 1;
+	}
+
 	if (i == -2 || mgo.numleft > 0) {
 		/* Either the user typed '-h', they made an error, or they added unrecognized command line arguments.
 		 * In all cases, print the help, and exit.
@@ -822,6 +837,7 @@ int openttd_main(int argc, char *argv[])
 
 	/* Reset windowing system, stop drivers, free used memory, ... */
 	ShutdownGame();
+	if (_export_tiles_failed) ret = 1;
 	return ret;
 }
 
@@ -867,6 +883,29 @@ static void OnStartGame(bool dedicated_server)
 	IConsoleCmdExec("exec scripts/game_start.scr 0");
 }
 
+/**
+ * Export the map tiles of the just loaded game and exit, if that was requested on the command line.
+ * When the game could not be loaded or exported, the game exits with an error.
+ * @param loaded Whether the game was loaded.
+ * @see ExportMapTiles
+ */
+static void ExportTilesAndExit(bool loaded)
+{
+	if (_export_tiles_dir.empty()) return;
+
+	uint num_written;
+	if (!loaded) {
+		fprintf(stderr, "Failed to load the savegame to export the map tiles of: %s\n", GetSaveLoadErrorString());
+		_export_tiles_failed = true;
+	} else if (!ExportMapTiles(_export_tiles_dir, true, &num_written)) {
+		fprintf(stderr, "Failed to export the map tiles to '%s'\n", _export_tiles_dir.c_str());
+		_export_tiles_failed = true;
+	}
+
+	_export_tiles_dir.clear();
+	_exit_game = true;
+}
+
 static void MakeNewGameDone()
 {
 	SettingsDisableElrail(_settings_game.vehicle.disable_elrails);
@@ -1058,7 +1097,8 @@ void SwitchToMode(SwitchMode new_mode)
 			ResetGRFConfig(true);
 			ResetWindowSystem();
 
-			if (!SafeLoad(_file_to_saveload.name, _file_to_saveload.file_op, _file_to_saveload.detail_ftype, GM_NORMAL, NO_DIRECTORY)) {
+			bool loaded = SafeLoad(_file_to_saveload.name, _file_to_saveload.file_op, _file_to_saveload.detail_ftype, GM_NORMAL, NO_DIRECTORY);
+			if (!loaded) {
 				SetDParamStr(0, GetSaveLoadErrorString());
 				ShowErrorMessage(STR_JUST_RAW_STRING, INVALID_STRING_ID, WL_ERROR);
 			} else {
@@ -1069,6 +1109,7 @@ void SwitchToMode(SwitchMode new_mode)
 				/* Decrease pause counter (was increased from opening load dialog) */
 				Command<CMD_PAUSE>::Post(PM_PAUSED_SAVELOAD, false);
 			}
+			ExportTilesAndExit(loaded);
 			break;
 		}
 
@@ -1182,6 +1223,17 @@ static void CheckCaches()
 		i++;
 	}
 
+	/* Check the company asset totals reduced on the worker threads. */
+	CompanyAssetTotals parallel_totals[MAX_COMPANIES];
+	CompanyAssetTotals serial_totals[MAX_COMPANIES];
+	GatherCompanyAssetTotals(parallel_totals, true);
+	GatherCompanyAssetTotals(serial_totals, false);
+	for (const Company *c : Company::Iterate()) {
+		if (parallel_totals[c->index] != serial_totals[c->index]) {
+			Debug(desync, 2, "company asset totals mismatch: company {}", c->index);
+		}
+	}
+
 	/* Strict checking of the road stop cache entries */
 	for (const RoadStop *rs : RoadStop::Iterate()) {
 		if (IsStandardRoadStopTile(rs->xy)) continue;
@@ -1470,8 +1522,6 @@ void GameLoop()
 		_switch_mode = SM_NONE;
 	}
 
-	IncreaseSpriteLRU();
-
 	/* Check for UDP stuff */
 	if (_network_available) NetworkBackgroundLoop();
 
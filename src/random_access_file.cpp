@@ -23,13 +23,17 @@
  */
 RandomAccessFile::RandomAccessFile(const std::string &filename, Subdirectory subdir) : filename(filename)
 {
-	this->file_handle = FioFOpenFile(filename, "rb", subdir);
+	size_t file_size;
+	this->file_handle = FioFOpenFile(filename, "rb", subdir, &file_size);
 	if (this->file_handle == nullptr) usererror("Cannot open file '%s'", filename.c_str());
 
 	/* When files are in a tar-file, the begin of the file might not be at 0. */
 	long pos = ftell(this->file_handle);
 	if (pos < 0) usererror("Cannot read file '%s'", filename.c_str());
 
+	this->start_pos = pos;
+	this->end_pos = this->start_pos + file_size;
+
 	/* Store the filename without path and extension */
 	auto t = filename.rfind(PATHSEPCHAR);
 	std::string name_without_path = filename.substr(t != std::string::npos ? t + 1 : 0);
@@ -75,6 +79,24 @@ size_t RandomAccessFile::GetPos() const
 	return this->pos + (this->buffer - this->buffer_end);
 }
 
+/**
+ * Get the position of the first byte of the file.
+ * @return Position in the file; not 0 when the file is in a tar-file.
+ */
+size_t RandomAccessFile::GetStartPos() const
+{
+	return this->start_pos;
+}
+
+/**
+ * Get the position just after the last byte of the file.
+ * @return Position in the file.
+ */
+size_t RandomAccessFile::GetEndPos() const
+{
+	return this->end_pos;
+}
+
 /**
  * Seek in the current file.
  * @param pos New position.
@@ -29,6 +29,8 @@ class RandomAccessFile {
 
 	FILE *file_handle;               ///< File handle of the open file.
 	size_t pos;                      ///< Position in the file of the end of the read buffer.
+	size_t start_pos;                ///< Position in the file of the first byte of the file.
+	size_t end_pos;                  ///< Position in the file of the byte after the last byte of the file.
 
 	byte *buffer;                    ///< Current position within the local buffer.
 	byte *buffer_end;                ///< Last valid byte of buffer.
@@ -45,6 +47,8 @@ public:
 	const std::string &GetSimplifiedFilename() const;
 
 	size_t GetPos() const;
+	size_t GetStartPos() const;
+	size_t GetEndPos() const;
 	void SeekTo(size_t pos, int mode);
 
 	byte ReadByte();
@@ -26,6 +26,7 @@
 #include "../roadveh.h"
 #include "../train.h"
 #include "../station_base.h"
+#include "../station_func.h"
 #include "../waypoint_base.h"
 #include "../roadstop_base.h"
 #include "../tunnelbridge_map.h"
@@ -2186,24 +2187,11 @@ bool AfterLoadGame()
 
 	if (IsSavegameVersionBefore(SLV_122)) {
 		/* Animated tiles would sometimes not be actually animated or
-		 * in case of old savegames duplicate. */
-
-		extern std::vector<TileIndex> _animated_tiles;
-
-		for (auto tile = _animated_tiles.begin(); tile < _animated_tiles.end(); /* Nothing */) {
+		 * in case of old savegames duplicate; the duplicates are already
+		 * gone when the animated tiles are loaded. */
+		for (TileIndex tile : GetAnimatedTiles()) {
 			/* Remove if tile is not animated */
-			bool remove = _tile_type_procs[tile_map.get(*tile).type]->animate_tile_proc == nullptr;
-
-			/* and remove if duplicate */
-			for (auto j = _animated_tiles.begin(); !remove && j < tile; j++) {
-				remove = *tile == *j;
-			}
-
-			if (remove) {
-				tile = _animated_tiles.erase(tile);
-			} else {
-				tile++;
-			}
+			if (_tile_type_procs[tile_map.get(tile).type]->animate_tile_proc == nullptr) DeleteAnimatedTile(tile);
 		}
 	}
 
@@ -3150,6 +3138,12 @@ bool AfterLoadGame()
 	/* Compute station catchment areas. This is needed here in case UpdateStationAcceptance is called below. */
 	Station::RecomputeCatchmentForAll();
 
+	/* Continue the rating updates of the stations from their delete counters. */
+	RebuildStationRatingSchedule();
+
+	/* Continue the production of the industries from their counters. */
+	RebuildIndustryProductionSchedule();
+
 	/* Station acceptance is some kind of cache */
 	if (IsSavegameVersionBefore(SLV_127)) {
 		for (Station *st : Station::Iterate()) UpdateStationAcceptance(st, false);
@@ -3161,6 +3155,9 @@ bool AfterLoadGame()
 	AfterLoadCompanyStats();
 	AfterLoadStoryBook();
 
+	/* The track layout may have been converted above. */
+	InvalidateSignalBlocks();
+
 	GamelogPrintDebug(1);
 
 	InitializeWindowsAndCaches();
@@ -3192,6 +3189,10 @@ void ReloadNewGRFData()
 	GroupStatistics::UpdateAfterLoad();
 	/* update station graphics */
 	AfterLoadStations();
+	/* House and industry tile acceptance might have changed */
+	for (Station *st : Station::Iterate()) st->cached_acceptance_valid = false;
+	/* Blocked station tiles might have changed */
+	InvalidateSignalBlocks();
 	/* Update company statistics. */
 	AfterLoadCompanyStats();
 	/* Check and update house and town values */
@@ -13,12 +13,12 @@
 #include "compat/animated_tile_sl_compat.h"
 
 #include "../tile_type.h"
-#include "../core/alloc_func.hpp"
-#include "../core/smallvec_type.hpp"
+#include "../animated_tile_func.h"
 
 #include "../safeguards.h"
 
-extern std::vector<TileIndex> _animated_tiles;
+/** The animated tiles in their animation order, while saving or loading them. */
+static std::vector<TileIndex> _animated_tiles;
 
 static const SaveLoad _animated_tile_desc[] = {
 	 SLEG_VECTOR("tiles", _animated_tiles, SLE_UINT32),
@@ -31,11 +31,21 @@ struct ANITChunkHandler : ChunkHandler {
 	{
 		SlTableHeader(_animated_tile_desc);
 
+		_animated_tiles = GetAnimatedTiles();
 		SlSetArrayIndex(0);
 		SlGlobList(_animated_tile_desc);
+		_animated_tiles.clear();
 	}
 
 	void Load() const override
+	{
+		_animated_tiles.clear();
+		this->LoadList();
+		SetAnimatedTiles(_animated_tiles);
+		_animated_tiles.clear();
+	}
+
+	void LoadList() const
 	{
 		/* Before version 80 we did NOT have a variable length animated tile table */
 		if (IsSavegameVersionBefore(SLV_80)) {
@@ -81,6 +81,9 @@ struct INDYChunkHandler : ChunkHandler {
 	{
 		SlTableHeader(_industry_desc);
 
+		/* The counters of the industries only count down with the industry tick clock. */
+		SyncIndustryCounters();
+
 		/* Write the industries */
 		for (Industry *ind : Industry::Iterate()) {
 			SlSetArrayIndex(ind->index);
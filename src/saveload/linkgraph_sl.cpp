@@ -27,6 +27,7 @@ typedef LinkGraph::BaseEdge Edge;
 static uint16 _num_nodes;
 static LinkGraph *_linkgraph; ///< Contains the current linkgraph being saved/loaded.
 static NodeID _linkgraph_from; ///< Contains the current "from" node being saved/loaded.
+static NodeID _linkgraph_next_edge; ///< Destination of the next edge in old savegames, which stored the edges of a node as linked list.
 
 class SlLinkgraphEdge : public DefaultSaveLoadHandler<SlLinkgraphEdge, Node> {
 public:
@@ -36,20 +37,16 @@ public:
 		SLE_CONDVAR(Edge, travel_time_sum,          SLE_UINT64, SLV_LINKGRAPH_TRAVEL_TIME, SL_MAX_VERSION),
 		    SLE_VAR(Edge, last_unrestricted_update, SLE_INT32),
 		SLE_CONDVAR(Edge, last_restricted_update,   SLE_INT32, SLV_187, SL_MAX_VERSION),
-		    SLE_VAR(Edge, next_edge,                SLE_UINT16),
+		SLEG_CONDVAR("next_edge", _linkgraph_next_edge, SLE_UINT16, SL_MIN_VERSION, SLV_LINKGRAPH_EDGES),
+		SLE_CONDVAR(Edge, dest_node,                SLE_UINT16, SLV_LINKGRAPH_EDGES, SL_MAX_VERSION),
 	};
 	inline const static SaveLoadCompatTable compat_description = _linkgraph_edge_sl_compat;
 
 	void Save(Node *bn) const override
 	{
-		uint16 size = 0;
-		for (NodeID to = _linkgraph_from; to != INVALID_NODE; to = _linkgraph->edges[_linkgraph_from][to].next_edge) {
-			size++;
-		}
-
-		SlSetStructListLength(size);
-		for (NodeID to = _linkgraph_from; to != INVALID_NODE; to = _linkgraph->edges[_linkgraph_from][to].next_edge) {
-			SlObject(&_linkgraph->edges[_linkgraph_from][to], this->GetDescription());
+		SlSetStructListLength(bn->edges.size());
+		for (Edge &edge : bn->edges) {
+			SlObject(&edge, this->GetDescription());
 		}
 	}
 
@@ -59,24 +56,59 @@ public:
 
 		if (IsSavegameVersionBefore(SLV_191)) {
 			/* We used to save the full matrix ... */
+			std::vector<Edge> edges(max_size);
+			std::vector<NodeID> next_edges(max_size);
 			for (NodeID to = 0; to < max_size; ++to) {
-				SlObject(&_linkgraph->edges[_linkgraph_from][to], this->GetLoadDescription());
+				SlObject(&edges[to], this->GetLoadDescription());
+				next_edges[to] = _linkgraph_next_edge;
 			}
+
+			/* Only the edges linked from the node itself are valid. */
+			for (NodeID to = next_edges[_linkgraph_from]; to != INVALID_NODE; to = next_edges[to]) {
+				if (to >= max_size || bn->edges.size() >= max_size) SlErrorCorrupt("Link graph structure overflow");
+				edges[to].dest_node = to;
+				bn->edges.push_back(edges[to]);
+			}
+			this->SortEdges(bn);
 			return;
 		}
 
 		size_t used_size = IsSavegameVersionBefore(SLV_SAVELOAD_LIST_LENGTH) ? max_size : SlGetStructListLength(UINT16_MAX);
 
-		/* ... but as that wasted a lot of space we save a sparse matrix now. */
-		for (NodeID to = _linkgraph_from; to != INVALID_NODE; to = _linkgraph->edges[_linkgraph_from][to].next_edge) {
-			if (used_size == 0) SlErrorCorrupt("Link graph structure overflow");
-			used_size--;
+		if (IsSavegameVersionBefore(SLV_LINKGRAPH_EDGES)) {
+			/* ... then we saved a linked list of the valid edges, starting
+			 * at the node itself ... */
+			for (NodeID to = _linkgraph_from; to != INVALID_NODE; to = _linkgraph_next_edge) {
+				if (used_size == 0) SlErrorCorrupt("Link graph structure overflow");
+				used_size--;
+
+				if (to >= max_size) SlErrorCorrupt("Link graph structure overflow");
+				Edge edge(to);
+				SlObject(&edge, this->GetLoadDescription());
+				if (to != _linkgraph_from) bn->edges.push_back(edge);
+			}
+
+			if (!IsSavegameVersionBefore(SLV_SAVELOAD_LIST_LENGTH) && used_size > 0) SlErrorCorrupt("Corrupted link graph");
+			this->SortEdges(bn);
+			return;
+		}
 
-			if (to >= max_size) SlErrorCorrupt("Link graph structure overflow");
-			SlObject(&_linkgraph->edges[_linkgraph_from][to], this->GetLoadDescription());
+		/* ... but now only the edges themselves are saved, sorted by destination. */
+		for (; used_size > 0; --used_size) {
+			Edge &edge = bn->edges.emplace_back();
+			SlObject(&edge, this->GetLoadDescription());
+			if (edge.dest_node >= max_size || edge.dest_node == _linkgraph_from) SlErrorCorrupt("Link graph structure overflow");
+			if (bn->edges.size() > 1 && bn->edges[bn->edges.size() - 2].dest_node >= edge.dest_node) SlErrorCorrupt("Corrupted link graph");
 		}
+	}
 
-		if (!IsSavegameVersionBefore(SLV_SAVELOAD_LIST_LENGTH) && used_size > 0) SlErrorCorrupt("Corrupted link graph");
+	/**
+	 * Sort the edges converted from an old savegame by destination.
+	 * @param bn Node the edges belong to.
+	 */
+	static void SortEdges(Node *bn)
+	{
+		std::sort(bn->edges.begin(), bn->edges.end(), [](const Edge &a, const Edge &b) { return a.dest_node < b.dest_node; });
 	}
 };
 
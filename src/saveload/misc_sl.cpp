@@ -87,6 +87,7 @@ static const SaveLoad _date_desc[] = {
 	SLEG_CONDVAR("next_competitor_start",  _next_competitor_start,  SLE_UINT32,                SLV_109, SL_MAX_VERSION),
 	    SLEG_VAR("trees_tick_counter",     _trees_tick_ctr,         SLE_UINT8),
 	SLEG_CONDVAR("pause_mode",             _pause_mode,             SLE_UINT8,                   SLV_4, SL_MAX_VERSION),
+	SLEG_CONDVAR("periodic_loops_pending", _periodic_loops_pending, SLE_UINT8,                   SLV_PERIODIC_LOOP_STEPS, SL_MAX_VERSION),
 };
 
 static const SaveLoad _date_check_desc[] = {
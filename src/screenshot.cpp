@@ -27,9 +27,17 @@
 #include "tile_map.h"
 #include "landscape.h"
 #include "video/video_driver.hpp"
+#include "thread.h"
+#include "thread_pool.h"
+#include "spritecache.h"
+#include "fontcache.h"
+#include "transparency.h"
 
 #include "table/strings.h"
 
+#include <condition_variable>
+#include <functional>
+
 #include "safeguards.h"
 
 static const char * const SCREENSHOT_NAME = "screenshot"; ///< Default filename of a saved screenshot.
@@ -73,6 +81,101 @@ struct ScreenshotFormat {
 
 #define MKCOLOUR(x)         TO_LE32X(x)
 
+/**
+ * Function signature for writing a batch of generated lines to a screenshot file.
+ * @param buf Buffer with the lines.
+ * @param n   Number of lines in the buffer.
+ * @return Whether the lines were written successfully.
+ */
+typedef std::function<bool(const uint8 *buf, uint n)> ScreenshotWriteProc;
+
+/**
+ * Generate the lines of a screenshot and write them to the file. Writing, and
+ * compressing, is done on another thread, so generating the next lines is
+ * done at the same time. Lines are generated in batches of \a maxlines, and
+ * only two batches are in memory at any time.
+ * @param callb    Callback function for generating lines of pixels.
+ * @param userdata User data, passed on to \a callb.
+ * @param w        Width of the image in pixels.
+ * @param h        Height of the image in pixels.
+ * @param bpp      Bytes per pixel.
+ * @param maxlines Number of lines per batch.
+ * @param write    Function writing a batch of lines to the file.
+ * @return All lines were written successfully.
+ */
+static bool WriteScreenshotLines(ScreenshotCallback *callb, void *userdata, uint w, uint h, uint bpp, uint maxlines, const ScreenshotWriteProc &write)
+{
+	std::vector<uint8> buffers[2];
+	for (auto &buffer : buffers) buffer.resize((size_t)w * maxlines * bpp);
+
+	std::mutex lock;
+	std::condition_variable cv;
+	uint lines[2] = { 0, 0 }; ///< Number of generated lines in each buffer that still have to be written.
+	bool done = false;        ///< All lines have been generated.
+	bool failed = false;      ///< Writing failed.
+
+	std::thread writer;
+	bool threaded = StartNewThread(&writer, "ottd:screenshot", [&]() {
+		for (uint i = 0;; i ^= 1) {
+			uint n;
+			{
+				std::unique_lock<std::mutex> guard(lock);
+				cv.wait(guard, [&]() { return lines[i] != 0 || done; });
+				if (lines[i] == 0) return;
+				n = lines[i];
+			}
+
+			bool ok = write(buffers[i].data(), n);
+
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				lines[i] = 0;
+				failed = !ok;
+			}
+			cv.notify_all();
+			if (!ok) return;
+		}
+	});
+
+	for (uint y = 0, i = 0; y != h; i ^= 1) {
+		/* determine # lines to write */
+		uint n = std::min(h - y, maxlines);
+
+		if (threaded) {
+			/* Wait until the lines previously generated into this buffer are written. */
+			std::unique_lock<std::mutex> guard(lock);
+			cv.wait(guard, [&]() { return lines[i] == 0 || failed; });
+			if (failed) break;
+		}
+
+		/* render the pixels into the buffer */
+		callb(userdata, buffers[i].data(), y, w, n);
+		y += n;
+
+		if (threaded) {
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				lines[i] = n;
+			}
+			cv.notify_all();
+		} else if (!write(buffers[i].data(), n)) {
+			failed = true;
+			break;
+		}
+	}
+
+	if (threaded) {
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			done = true;
+		}
+		cv.notify_all();
+		writer.join();
+	}
+
+	return !failed;
+}
+
 /*************************************************
  **** SCREENSHOT CODE FOR WINDOWS BITMAP (.BMP)
  *************************************************/
@@ -263,7 +366,7 @@ static bool MakePNGImage(const char *name, ScreenshotCallback *callb, void *user
 {
 	png_color rq[256];
 	FILE *f;
-	uint i, y, n;
+	uint i;
 	uint maxlines;
 	uint bpp = pixelformat / 8;
 	png_structp png_ptr;
@@ -372,28 +475,32 @@ static bool MakePNGImage(const char *name, ScreenshotCallback *callb, void *user
 	/* use by default 64k temp memory */
 	maxlines = Clamp(65536 / w, 16, 128);
 
-	/* now generate the bitmap bits */
-	void *buff = CallocT<uint8>(w * maxlines * bpp); // by default generate 128 lines at a time.
+	/* now generate the bitmap bits, and write them to png */
+	bool ok = WriteScreenshotLines(callb, userdata, w, h, bpp, maxlines, [png_ptr, w, bpp](const uint8 *buf, uint n) {
+		/* Errors while compressing jump back to the thread doing the compression. */
+		if (setjmp(png_jmpbuf(png_ptr))) return false;
 
-	y = 0;
-	do {
-		/* determine # lines to write */
-		n = std::min(h - y, maxlines);
+		for (uint i = 0; i != n; i++) {
+			png_write_row(png_ptr, (png_const_bytep)buf + i * w * bpp);
+		}
+		return true;
+	});
 
-		/* render the pixels into the buffer */
-		callb(userdata, buff, y, w, n);
-		y += n;
+	if (!ok) {
+		png_destroy_write_struct(&png_ptr, &info_ptr);
+		fclose(f);
+		return false;
+	}
 
-		/* write them to png */
-		for (i = 0; i != n; i++) {
-			png_write_row(png_ptr, (png_bytep)buff + i * w * bpp);
-		}
-	} while (y != h);
+	if (setjmp(png_jmpbuf(png_ptr))) {
+		png_destroy_write_struct(&png_ptr, &info_ptr);
+		fclose(f);
+		return false;
+	}
 
 	png_write_end(png_ptr, info_ptr);
 	png_destroy_write_struct(&png_ptr, &info_ptr);
 
-	free(buff);
 	fclose(f);
 	return true;
 }
@@ -606,16 +713,17 @@ static void CurrentScreenCallback(void *userdata, void *buf, uint y, uint pitch,
 }
 
 /**
- * generate a large piece of the world
- * @param userdata Viewport area to draw
+ * Draw a part of the world, as seen by a screenshot viewport, into a buffer.
+ * @param vp Viewport area to draw
  * @param buf Videobuffer with same bitdepth as current blitter
+ * @param x First column to render
  * @param y First line to render
+ * @param w Number of columns to render
+ * @param h Number of lines to render
  * @param pitch Pitch of the videobuffer
- * @param n Number of lines to render
  */
-static void LargeWorldCallback(void *userdata, void *buf, uint y, uint pitch, uint n)
+static void DrawWorldArea(const Viewport *vp, void *buf, int x, int y, int w, int h, uint pitch)
 {
-	Viewport *vp = (Viewport *)userdata;
 	DrawPixelInfo dpi, *old_dpi;
 	int wx, left;
 
@@ -625,7 +733,7 @@ static void LargeWorldCallback(void *userdata, void *buf, uint y, uint pitch, ui
 
 	_screen.dst_ptr = buf;
 	_screen.width = pitch;
-	_screen.height = n;
+	_screen.height = h;
 	_screen.pitch = pitch;
 	_screen_disable_anim = true;
 
@@ -633,24 +741,24 @@ static void LargeWorldCallback(void *userdata, void *buf, uint y, uint pitch, ui
 	_cur_dpi = &dpi;
 
 	dpi.dst_ptr = buf;
-	dpi.height = n;
-	dpi.width = vp->width;
+	dpi.height = h;
+	dpi.width = w;
 	dpi.pitch = pitch;
 	dpi.zoom = ZOOM_LVL_WORLD_SCREENSHOT;
-	dpi.left = 0;
+	dpi.left = x;
 	dpi.top = y;
 
 	/* Render viewport in blocks of 1600 pixels width */
-	left = 0;
-	while (vp->width - left != 0) {
-		wx = std::min(vp->width - left, 1600);
+	left = x;
+	while (x + w - left != 0) {
+		wx = std::min(x + w - left, 1600);
 		left += wx;
 
 		ViewportDoDraw(vp,
 			ScaleByZoom(left - wx - vp->left, vp->zoom) + vp->virtual_left,
 			ScaleByZoom(y - vp->top, vp->zoom) + vp->virtual_top,
 			ScaleByZoom(left - vp->left, vp->zoom) + vp->virtual_left,
-			ScaleByZoom((y + n) - vp->top, vp->zoom) + vp->virtual_top
+			ScaleByZoom((y + h) - vp->top, vp->zoom) + vp->virtual_top
 		);
 	}
 
@@ -661,6 +769,20 @@ static void LargeWorldCallback(void *userdata, void *buf, uint y, uint pitch, ui
 	_screen_disable_anim = old_disable_anim;
 }
 
+/**
+ * generate a large piece of the world
+ * @param userdata Viewport area to draw
+ * @param buf Videobuffer with same bitdepth as current blitter
+ * @param y First line to render
+ * @param pitch Pitch of the videobuffer
+ * @param n Number of lines to render
+ */
+static void LargeWorldCallback(void *userdata, void *buf, uint y, uint pitch, uint n)
+{
+	Viewport *vp = (Viewport *)userdata;
+	DrawWorldArea(vp, buf, 0, y, vp->width, n, pitch);
+}
+
 /**
  * Construct a pathname for a screenshot file.
  * @param default_fn Default filename.
@@ -1065,3 +1187,395 @@ bool MakeMinimapWorldScreenshot()
 	const ScreenshotFormat *sf = _screenshot_formats + _cur_screenshot_format;
 	return sf->proc(MakeScreenshotName(SCREENSHOT_NAME, sf->extension), MinimapScreenCallback, nullptr, tile_map.size_x, tile_map.size_y, 32, _cur_palette.palette);
 }
+
+/*************************************************
+ **** MAP TILE EXPORT
+ *************************************************/
+
+/** Size in pixels of the square tiles of an exported map. */
+static const uint MAP_TILE_SIZE = 256;
+
+/** State of the last map tile export, so the next export only has to redo the changed tiles. */
+static struct MapTileExport {
+	std::string dir;         ///< Directory the tiles were exported to, or empty when there is no usable export.
+	int virtual_left;        ///< Virtual X coordinate of the left of the exported area.
+	int virtual_top;         ///< Virtual Y coordinate of the top of the exported area.
+	uint tiles_x;            ///< Number of tiles horizontally at the most detailed level.
+	uint tiles_y;            ///< Number of tiles vertically at the most detailed level.
+	uint bpp;                ///< Bytes per pixel of the exported tiles.
+	byte display_opt;        ///< Display options the tiles were drawn with.
+	TransparencyOptionBits transparency; ///< Transparency options the tiles were drawn with.
+	TransparencyOptionBits invisibility; ///< Invisibility options the tiles were drawn with.
+	std::vector<bool> dirty; ///< Tiles at the most detailed level that changed since the export.
+} _map_tile_export;
+
+/**
+ * Mark the exported map tiles covering an area of the world as changed.
+ * @param left Left edge of the area, in virtual coordinates.
+ * @param top Top edge of the area, in virtual coordinates.
+ * @param right Right edge of the area, in virtual coordinates.
+ * @param bottom Bottom edge of the area, in virtual coordinates.
+ */
+void MarkMapTilesDirty(int left, int top, int right, int bottom)
+{
+	MapTileExport &e = _map_tile_export;
+	if (e.dir.empty()) return;
+
+	int x1 = UnScaleByZoomLower(left - e.virtual_left, ZOOM_LVL_WORLD_SCREENSHOT);
+	int y1 = UnScaleByZoomLower(top - e.virtual_top, ZOOM_LVL_WORLD_SCREENSHOT);
+	int x2 = UnScaleByZoom(right - e.virtual_left, ZOOM_LVL_WORLD_SCREENSHOT);
+	int y2 = UnScaleByZoom(bottom - e.virtual_top, ZOOM_LVL_WORLD_SCREENSHOT);
+	if (x2 <= 0 || y2 <= 0) return;
+
+	uint tx1 = std::max(x1, 0) / MAP_TILE_SIZE;
+	uint ty1 = std::max(y1, 0) / MAP_TILE_SIZE;
+	uint tx2 = std::min<uint>((x2 - 1) / MAP_TILE_SIZE, e.tiles_x - 1);
+	uint ty2 = std::min<uint>((y2 - 1) / MAP_TILE_SIZE, e.tiles_y - 1);
+
+	for (uint ty = ty1; ty <= ty2; ty++) {
+		for (uint tx = tx1; tx <= tx2; tx++) {
+			e.dirty[ty * e.tiles_x + tx] = true;
+		}
+	}
+}
+
+/**
+ * Forget the last map tile export, so the next export redoes all tiles.
+ * Call this when something changes the look of the whole world, without marking it dirty tile by tile.
+ */
+void InvalidateMapTiles()
+{
+	_map_tile_export.dir.clear();
+}
+
+#if defined(WITH_PNG)
+/**
+ * Get the filename of a map tile, in the XYZ layout of web map viewers.
+ * @param dir Directory with the tiles.
+ * @param level Zoom level of the tile, 0 being a single tile for the whole map.
+ * @param x Column of the tile.
+ * @param y Row of the tile.
+ * @return The filename.
+ */
+static std::string GetMapTileName(const std::string &dir, uint level, uint x, uint y)
+{
+	return fmt::format("{}{}" PATHSEP "{}" PATHSEP "{}.png", dir, level, x, y);
+}
+
+/**
+ * Create the directories for map tiles.
+ * @param dir Directory with the tiles.
+ * @param level Zoom level of the tiles.
+ * @param tiles The tiles.
+ */
+static void CreateMapTileDirectories(const std::string &dir, uint level, const std::vector<std::pair<uint, uint>> &tiles)
+{
+	std::string level_dir = fmt::format("{}{}" PATHSEP, dir, level);
+	FioCreateDirectory(level_dir);
+
+	uint last_x = UINT_MAX;
+	for (const auto &tile : tiles) {
+		if (tile.first == last_x) continue;
+		last_x = tile.first;
+		FioCreateDirectory(fmt::format("{}{}" PATHSEP, level_dir, tile.first));
+	}
+}
+
+/**
+ * Write a map tile to a PNG file.
+ * @param name Filename of the tile.
+ * @param buf Pixels of the tile.
+ * @param bpp Bytes per pixel, either 1 or 4.
+ * @return The tile was written successfully.
+ */
+static bool WriteMapTile(const std::string &name, const uint8 *buf, uint bpp)
+{
+	FILE *f = fopen(name.c_str(), "wb");
+	if (f == nullptr) return false;
+
+	png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, const_cast<char *>(name.c_str()), png_my_error, png_my_warning);
+	png_infop info_ptr = png_ptr != nullptr ? png_create_info_struct(png_ptr) : nullptr;
+	if (info_ptr == nullptr) {
+		png_destroy_write_struct(&png_ptr, (png_infopp)nullptr);
+		fclose(f);
+		return false;
+	}
+
+	if (setjmp(png_jmpbuf(png_ptr))) {
+		png_destroy_write_struct(&png_ptr, &info_ptr);
+		fclose(f);
+		return false;
+	}
+
+	png_init_io(png_ptr, f);
+	png_set_filter(png_ptr, 0, PNG_FILTER_NONE);
+	png_set_IHDR(png_ptr, info_ptr, MAP_TILE_SIZE, MAP_TILE_SIZE, 8, bpp == 1 ? PNG_COLOR_TYPE_PALETTE : PNG_COLOR_TYPE_RGB,
+		PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+
+	if (bpp == 1) {
+		png_color rq[256];
+		for (uint i = 0; i != 256; i++) {
+			rq[i].red   = _cur_palette.palette[i].r;
+			rq[i].green = _cur_palette.palette[i].g;
+			rq[i].blue  = _cur_palette.palette[i].b;
+		}
+		png_set_PLTE(png_ptr, info_ptr, rq, 256);
+	}
+
+	png_write_info(png_ptr, info_ptr);
+
+	if (bpp == 4) {
+#if TTD_ENDIAN == TTD_LITTLE_ENDIAN
+		png_set_bgr(png_ptr);
+		png_set_filler(png_ptr, 0, PNG_FILLER_AFTER);
+#else
+		png_set_filler(png_ptr, 0, PNG_FILLER_BEFORE);
+#endif /* TTD_ENDIAN == TTD_LITTLE_ENDIAN */
+	}
+
+	for (uint y = 0; y != MAP_TILE_SIZE; y++) {
+		png_write_row(png_ptr, (png_const_bytep)buf + y * MAP_TILE_SIZE * bpp);
+	}
+
+	png_write_end(png_ptr, info_ptr);
+	png_destroy_write_struct(&png_ptr, &info_ptr);
+
+	fclose(f);
+	return true;
+}
+
+/**
+ * Read a map tile that was written by #WriteMapTile.
+ * @param name Filename of the tile.
+ * @param[out] buf Pixels of the tile.
+ * @param bpp Bytes per pixel, either 1 or 4.
+ * @return The tile was read successfully.
+ */
+static bool ReadMapTile(const std::string &name, uint8 *buf, uint bpp)
+{
+	FILE *f = fopen(name.c_str(), "rb");
+	if (f == nullptr) return false;
+
+	png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, const_cast<char *>(name.c_str()), png_my_error, png_my_warning);
+	png_infop info_ptr = png_ptr != nullptr ? png_create_info_struct(png_ptr) : nullptr;
+	if (info_ptr == nullptr) {
+		png_destroy_read_struct(&png_ptr, (png_infopp)nullptr, (png_infopp)nullptr);
+		fclose(f);
+		return false;
+	}
+
+	if (setjmp(png_jmpbuf(png_ptr))) {
+		png_destroy_read_struct(&png_ptr, &info_ptr, (png_infopp)nullptr);
+		fclose(f);
+		return false;
+	}
+
+	png_init_io(png_ptr, f);
+	png_read_info(png_ptr, info_ptr);
+
+	bool valid = png_get_image_width(png_ptr, info_ptr) == MAP_TILE_SIZE && png_get_image_height(png_ptr, info_ptr) == MAP_TILE_SIZE &&
+			png_get_bit_depth(png_ptr, info_ptr) == 8 && png_get_interlace_type(png_ptr, info_ptr) == PNG_INTERLACE_NONE &&
+			png_get_color_type(png_ptr, info_ptr) == (bpp == 1 ? PNG_COLOR_TYPE_PALETTE : PNG_COLOR_TYPE_RGB);
+
+	if (valid) {
+		if (bpp == 4) {
+#if TTD_ENDIAN == TTD_LITTLE_ENDIAN
+			png_set_bgr(png_ptr);
+			png_set_filler(png_ptr, 0, PNG_FILLER_AFTER);
+#else
+			png_set_filler(png_ptr, 0, PNG_FILLER_BEFORE);
+#endif /* TTD_ENDIAN == TTD_LITTLE_ENDIAN */
+		}
+		png_read_update_info(png_ptr, info_ptr);
+
+		for (uint y = 0; y != MAP_TILE_SIZE; y++) {
+			png_read_row(png_ptr, buf + y * MAP_TILE_SIZE * bpp, nullptr);
+		}
+	}
+
+	png_destroy_read_struct(&png_ptr, &info_ptr, (png_infopp)nullptr);
+	fclose(f);
+	return valid;
+}
+
+/**
+ * Scale a map tile down to a quarter of a tile of the next less detailed level.
+ * Colours are averaged; palette images take the top left pixel of every 2x2 block.
+ * @param child Pixels of the tile.
+ * @param[out] parent Pixels of the tile at the next level.
+ * @param qx Column of the quarter of \a parent to write to.
+ * @param qy Row of the quarter of \a parent to write to.
+ * @param bpp Bytes per pixel, either 1 or 4.
+ */
+static void ScaleDownMapTile(const uint8 *child, uint8 *parent, uint qx, uint qy, uint bpp)
+{
+	const uint half = MAP_TILE_SIZE / 2;
+	const uint pitch = MAP_TILE_SIZE * bpp;
+
+	for (uint y = 0; y != half; y++) {
+		const uint8 *src = child + 2 * y * pitch;
+		uint8 *dst = parent + (qy * half + y) * pitch + qx * half * bpp;
+
+		for (uint x = 0; x != half; x++) {
+			if (bpp == 1) {
+				dst[x] = src[2 * x];
+				continue;
+			}
+			for (uint c = 0; c != bpp; c++) {
+				const uint8 *p = src + 2 * x * bpp + c;
+				dst[x * bpp + c] = (p[0] + p[bpp] + p[pitch] + p[pitch + bpp] + 2) / 4;
+			}
+		}
+	}
+}
+
+/**
+ * Switch the blitter for exporting map tiles, clearing everything that was
+ * drawn by or for the previous one.
+ * @param name Name of the blitter to switch to.
+ * @return Whether the blitter was switched.
+ */
+static bool SwitchMapTileBlitter(const char *name)
+{
+	CancelSpritePrefetch();
+	if (BlitterFactory::SelectBlitter(name) == nullptr) return false;
+	ClearFontCache();
+	GfxClearSpriteCache();
+	return true;
+}
+#endif /* WITH_PNG */
+
+/**
+ * Export the world as a pyramid of PNG tiles for web map viewers. The tiles
+ * are #MAP_TILE_SIZE pixels square, in the XYZ layout: \c level/x/y.png. The
+ * most detailed level is rendered like a giant screenshot, every less detailed
+ * level is scaled down from the level below it, until a single tile covers
+ * the whole world. Unless \a full is set, only the tiles of which the area was
+ * marked dirty since the last export to the same directory are redone.
+ *
+ * Drawing the world is not thread-safe, so the most detailed tiles are drawn
+ * one after another; they are compressed and written, and the less detailed
+ * levels are made, on all cores.
+ * @param name Name of the directory in the screenshot directory to export to.
+ * @param full Whether to redo all tiles.
+ * @param[out] num_written The number of tiles that were written.
+ * @return The export was successful.
+ */
+bool ExportMapTiles(const std::string &name, bool full, uint *num_written)
+{
+	*num_written = 0;
+#if defined(WITH_PNG)
+	std::string dir = FiosGetScreenshotDir();
+	dir += name;
+	AppendPathSeparator(dir);
+
+	/* The null blitter of dedicated servers draws nothing; draw with a real one during the export. */
+	const char *old_blitter = nullptr;
+	if (BlitterFactory::GetCurrentBlitter()->GetScreenDepth() == 0) {
+		old_blitter = BlitterFactory::GetCurrentBlitter()->GetName();
+		if (!SwitchMapTileBlitter("32bpp-optimized")) {
+			SwitchMapTileBlitter(old_blitter);
+			return false;
+		}
+	}
+	const uint bpp = BlitterFactory::GetCurrentBlitter()->GetScreenDepth() / 8;
+
+	Viewport vp;
+	SetupScreenshotViewport(SC_WORLD, &vp);
+	const uint tiles_x = CeilDiv(vp.width, MAP_TILE_SIZE);
+	const uint tiles_y = CeilDiv(vp.height, MAP_TILE_SIZE);
+	uint max_level = 0;
+	while ((MAP_TILE_SIZE << max_level) < (uint)std::max(vp.width, vp.height)) max_level++;
+
+	MapTileExport &e = _map_tile_export;
+	if (full || e.dir != dir || e.virtual_left != vp.virtual_left || e.virtual_top != vp.virtual_top ||
+			e.tiles_x != tiles_x || e.tiles_y != tiles_y || e.bpp != bpp || e.display_opt != _display_opt ||
+			e.transparency != _transparency_opt || e.invisibility != _invisibility_opt) {
+		e.dir = dir;
+		e.virtual_left = vp.virtual_left;
+		e.virtual_top = vp.virtual_top;
+		e.tiles_x = tiles_x;
+		e.tiles_y = tiles_y;
+		e.bpp = bpp;
+		e.display_opt = _display_opt;
+		e.transparency = _transparency_opt;
+		e.invisibility = _invisibility_opt;
+		e.dirty.assign(tiles_x * tiles_y, true);
+	}
+
+	/* The tiles to redo at the current level, sorted by column. */
+	std::vector<std::pair<uint, uint>> tiles;
+	for (uint x = 0; x != tiles_x; x++) {
+		for (uint y = 0; y != tiles_y; y++) {
+			if (e.dirty[y * tiles_x + x]) tiles.emplace_back(x, y);
+		}
+	}
+	e.dirty.assign(tiles_x * tiles_y, false);
+
+	FioCreateDirectory(dir);
+	const size_t tile_bytes = MAP_TILE_SIZE * MAP_TILE_SIZE * bpp;
+	bool ok = true;
+
+	/* Draw the most detailed level in batches, writing each batch in parallel. */
+	CreateMapTileDirectories(dir, max_level, tiles);
+	const size_t batch_size = GetWorkerThreadCount() * 4;
+	std::vector<uint8> buffer(batch_size * tile_bytes);
+	std::vector<byte> written(batch_size);
+	for (size_t first = 0; ok && first < tiles.size(); first += batch_size) {
+		uint count = (uint)std::min(batch_size, tiles.size() - first);
+		std::fill(buffer.begin(), buffer.begin() + count * tile_bytes, 0);
+		for (uint i = 0; i != count; i++) {
+			const auto &tile = tiles[first + i];
+			DrawWorldArea(&vp, buffer.data() + i * tile_bytes, tile.first * MAP_TILE_SIZE, tile.second * MAP_TILE_SIZE, MAP_TILE_SIZE, MAP_TILE_SIZE, MAP_TILE_SIZE);
+		}
+
+		ParallelFor(count, [&](uint i) {
+			const auto &tile = tiles[first + i];
+			written[i] = WriteMapTile(GetMapTileName(dir, max_level, tile.first, tile.second), buffer.data() + i * tile_bytes, bpp);
+		});
+		ok = std::all_of(written.begin(), written.begin() + count, [](byte w) { return w != 0; });
+		*num_written += count;
+	}
+
+	/* Scale down every level to the next, redoing the tiles of which a quarter changed. */
+	for (uint level = max_level; ok && level-- > 0;) {
+		const uint shift = max_level - level;
+		const uint level_tiles_x = CeilDiv(tiles_x, 1 << (shift - 1));
+		const uint level_tiles_y = CeilDiv(tiles_y, 1 << (shift - 1));
+
+		for (auto &tile : tiles) tile = { tile.first / 2, tile.second / 2 };
+		std::sort(tiles.begin(), tiles.end());
+		tiles.erase(std::unique(tiles.begin(), tiles.end()), tiles.end());
+		CreateMapTileDirectories(dir, level, tiles);
+
+		written.resize(tiles.size());
+		ParallelFor((uint)tiles.size(), [&](uint i) {
+			std::vector<uint8> child(tile_bytes);
+			std::vector<uint8> parent(tile_bytes, 0);
+			const auto &tile = tiles[i];
+			for (uint qy = 0; qy != 2; qy++) {
+				for (uint qx = 0; qx != 2; qx++) {
+					uint cx = tile.first * 2 + qx;
+					uint cy = tile.second * 2 + qy;
+					if (cx >= level_tiles_x || cy >= level_tiles_y) continue;
+					if (!ReadMapTile(GetMapTileName(dir, level + 1, cx, cy), child.data(), bpp)) continue;
+					ScaleDownMapTile(child.data(), parent.data(), qx, qy, bpp);
+				}
+			}
+			written[i] = WriteMapTile(GetMapTileName(dir, level, tile.first, tile.second), parent.data(), bpp);
+		});
+		ok = std::all_of(written.begin(), written.end(), [](byte w) { return w != 0; });
+		*num_written += (uint)tiles.size();
+	}
+
+	/* Tiles that could not be written are not known; redo everything next time. */
+	if (!ok) e.dir.clear();
+
+	if (old_blitter != nullptr) SwitchMapTileBlitter(old_blitter);
+
+	Debug(misc, 1, "Exported {} map tiles to '{}', {} zoom levels", *num_written, dir, max_level + 1);
+	return ok;
+#else
+	return false;
+#endif /* WITH_PNG */
+}
@@ -31,6 +31,10 @@ void MakeScreenshotWithConfirm(ScreenshotType t);
 bool MakeScreenshot(ScreenshotType t, std::string name, uint32 width = 0, uint32 height = 0);
 bool MakeMinimapWorldScreenshot();
 
+bool ExportMapTiles(const std::string &name, bool full, uint *num_written);
+void MarkMapTilesDirty(int left, int top, int right, int bottom);
+void InvalidateMapTiles();
+
 extern std::string _screenshot_format_name;
 extern uint _num_screenshot_formats;
 extern uint _cur_screenshot_format;
@@ -273,6 +273,7 @@ static void SpriteZoomMinChanged(int32 new_value)
 {
 	GfxClearSpriteCache();
 	/* Force all sprites to redraw at the new chosen zoom level */
+	InvalidateMapTiles();
 	MarkWholeScreenDirty();
 }
 
@@ -406,6 +407,9 @@ static void UpdateFreeformEdges(int32 new_value)
 			tile_map.get(tile_map.tile(0, i)).type = MP_WATER;
 		}
 	}
+	/* Whether tiles near the edge are inert depends on this setting. */
+	tile_map.inert_tiles.assign(tile_map.size, false);
+	InvalidateMapTiles();
 	MarkWholeScreenDirty();
 }
 
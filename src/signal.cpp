@@ -16,17 +16,14 @@
 #include "train.h"
 #include "company_base.h"
 
+#include <unordered_map>
+
 #include "safeguards.h"
 
 
 /** these are the maximums used for updating signal blocks */
-static const uint SIG_TBU_SIZE    =  64; ///< number of signals entering to block
-static const uint SIG_TBD_SIZE    = 256; ///< number of intersections - open nodes in current block
-static const uint SIG_GLOB_SIZE   = 128; ///< number of open blocks (block can be opened more times until detected)
 static const uint SIG_GLOB_UPDATE =  64; ///< how many items need to be in _globset to force update
 
-static_assert(SIG_GLOB_UPDATE <= SIG_GLOB_SIZE);
-
 /** incidating trackbits with given enterdir */
 static const TrackBits _enterdir_to_trackbits[DIAGDIR_END] = {
 	TRACK_BIT_3WAY_NE,
@@ -44,71 +41,46 @@ static const TrackdirBits _enterdir_to_trackdirbits[DIAGDIR_END] = {
 };
 
 /**
- * Set containing 'items' items of 'tile and Tdir'
+ * Set containing items of 'tile and Tdir'
  * No tree structure is used because it would cause
  * slowdowns in most usual cases
  */
-template <typename Tdir, uint items>
+template <typename Tdir>
 struct SmallSet {
 private:
-	uint n;           // actual number of units
-	bool overflowed;  // did we try to overflow the set?
-	const char *name; // name, used for debugging purposes...
-
 	/** Element of set */
 	struct SSdata {
 		TileIndex tile;
 		Tdir dir;
-	} data[items];
+	};
 
-public:
-	/** Constructor - just set default values and 'name' */
-	SmallSet(const char *name) : n(0), overflowed(false), name(name) { }
+	std::vector<SSdata> data; ///< Elements of the set.
 
+public:
 	/** Reset variables to default values */
 	void Reset()
 	{
-		this->n = 0;
-		this->overflowed = false;
-	}
-
-	/**
-	 * Returns value of 'overflowed'
-	 * @return did we try to overflow the set?
-	 */
-	bool Overflowed()
-	{
-		return this->overflowed;
+		this->data.clear();
 	}
 
 	/**
 	 * Checks for empty set
 	 * @return is the set empty?
 	 */
-	bool IsEmpty()
+	bool IsEmpty() const
 	{
-		return this->n == 0;
-	}
-
-	/**
-	 * Checks for full set
-	 * @return is the set full?
-	 */
-	bool IsFull()
-	{
-		return this->n == lengthof(data);
+		return this->data.empty();
 	}
 
 	/**
 	 * Reads the number of items
 	 * @return current number of items
 	 */
-	uint Items()
+	uint Items() const
 	{
-		return this->n;
+		return (uint)this->data.size();
 	}
 
-
 	/**
 	 * Tries to remove first instance of given tile and dir
 	 * @param tile tile
@@ -117,9 +89,10 @@ public:
 	 */
 	bool Remove(TileIndex tile, Tdir dir)
 	{
-		for (uint i = 0; i < this->n; i++) {
-			if (this->data[i].tile == tile && this->data[i].dir == dir) {
-				this->data[i] = this->data[--this->n];
+		for (auto it = this->data.begin(); it != this->data.end(); ++it) {
+			if (it->tile == tile && it->dir == dir) {
+				*it = this->data.back();
+				this->data.pop_back();
 				return true;
 			}
 		}
@@ -133,35 +106,23 @@ public:
 	 * @param dir and dir to find
 	 * @return true iff the tile & dir element was found
 	 */
-	bool IsIn(TileIndex tile, Tdir dir)
+	bool IsIn(TileIndex tile, Tdir dir) const
 	{
-		for (uint i = 0; i < this->n; i++) {
-			if (this->data[i].tile == tile && this->data[i].dir == dir) return true;
+		for (const SSdata &d : this->data) {
+			if (d.tile == tile && d.dir == dir) return true;
 		}
 
 		return false;
 	}
 
 	/**
-	 * Adds tile & dir into the set, checks for full set
-	 * Sets the 'overflowed' flag if the set was full
+	 * Adds tile & dir into the set
 	 * @param tile tile
 	 * @param dir and dir to add
-	 * @return true iff the item could be added (set wasn't full)
 	 */
-	bool Add(TileIndex tile, Tdir dir)
+	void Add(TileIndex tile, Tdir dir)
 	{
-		if (this->IsFull()) {
-			overflowed = true;
-			Debug(misc, 0, "SignalSegment too complex. Set {} is full (maximum {})", name, items);
-			return false; // set is full
-		}
-
-		this->data[this->n].tile = tile;
-		this->data[this->n].dir = dir;
-		this->n++;
-
-		return true;
+		this->data.push_back({tile, dir});
 	}
 
 	/**
@@ -172,20 +133,21 @@ public:
 	 */
 	bool Get(TileIndex *tile, Tdir *dir)
 	{
-		if (this->n == 0) return false;
+		if (this->data.empty()) return false;
 
-		this->n--;
-		*tile = this->data[this->n].tile;
-		*dir = this->data[this->n].dir;
+		*tile = this->data.back().tile;
+		*dir = this->data.back().dir;
+		this->data.pop_back();
 
 		return true;
 	}
-};
 
-static SmallSet<Trackdir, SIG_TBU_SIZE> _tbuset("_tbuset");         ///< set of signals that will be updated
-static SmallSet<DiagDirection, SIG_TBD_SIZE> _tbdset("_tbdset");    ///< set of open nodes in current signal block
-static SmallSet<DiagDirection, SIG_GLOB_SIZE> _globset("_globset"); ///< set of places to be updated in following runs
+	auto begin() const { return this->data.begin(); }
+	auto end() const { return this->data.end(); }
+};
 
+static SmallSet<DiagDirection> _tbdset; ///< set of open nodes in current signal block
+static SmallSet<DiagDirection> _globset; ///< set of places to be updated in following runs
 
 /** Check whether there is a train on rail, not in a depot */
 static Vehicle *TrainOnTileEnum(Vehicle *v, void *)
@@ -196,11 +158,154 @@ static Vehicle *TrainOnTileEnum(Vehicle *v, void *)
 }
 
 
+/**
+ * A signal block as found by ExploreSegment.
+ * The layout dependent part of a flood is stored here, so later updates of the
+ * same block only have to look at its signals and, when a train may be inside,
+ * at its tiles. Blocks stay valid until the track layout changes.
+ */
+struct SignalBlock {
+	/** A (tile, trackdir) pair of a signal bordering the block. */
+	struct Signal {
+		TileIndex tile;
+		Trackdir trackdir;
+
+		bool operator <(const Signal &other) const
+		{
+			return this->tile != other.tile ? this->tile < other.tile : this->trackdir < other.trackdir;
+		}
+	};
+
+	/** A tile to check for trains; TRACK_BIT_NONE checks the whole tile except depots. */
+	struct Probe {
+		TileIndex tile;
+		TrackBits tracks;
+	};
+
+	Owner owner;                    ///< Owner whose signals were followed.
+	bool pbs;                       ///< The block contains a path signal.
+	std::vector<Probe> probes;      ///< Checks for trains in the block.
+	std::vector<Signal> signals;    ///< Conventional signals facing into the block, sorted.
+	std::vector<Signal> exits;      ///< Pre-signal exits leading out of the block.
+	std::vector<TileIndex> tiles;   ///< Unique tiles of #probes.
+	std::vector<uint64> nodes;      ///< Keys of the nodes of the block in #_signal_block_nodes.
+	uint trains;                    ///< Number of train vehicles on #tiles.
+};
+
+static std::vector<SignalBlock> _signal_blocks;                            ///< Known signal blocks, including released ones.
+static std::vector<uint> _free_signal_blocks;                              ///< Indices of released entries in #_signal_blocks.
+static std::unordered_map<uint64, uint> _signal_block_nodes;              ///< (tile, enterdir, owner) to index in #_signal_blocks.
+static std::unordered_map<uint32, std::vector<uint>> _signal_block_tiles; ///< Tile to indices of the blocks it is part of.
+static std::unordered_map<uint32, uint> _train_tile_count;                ///< Number of train vehicles per tile.
+
+/**
+ * Key of a node in the signal block graph.
+ * @param tile tile we are entering
+ * @param dir direction (tile side) we are entering, or INVALID_DIAGDIR
+ * @param owner owner whose signals are followed
+ * @return the key
+ */
+static inline uint64 SignalNodeKey(TileIndex tile, DiagDirection dir, Owner owner)
+{
+	return (uint64)(uint32)tile << 16 | (uint64)(uint8)dir << 8 | (uint8)owner;
+}
+
+/**
+ * Forget all known signal blocks.
+ * Has to be called whenever something changes the layout signals are following,
+ * i.e. track pieces, signals, depots, stations, tunnels, bridges and owners.
+ */
+void InvalidateSignalBlocks()
+{
+	_signal_blocks.clear();
+	_free_signal_blocks.clear();
+	_signal_block_nodes.clear();
+	_signal_block_tiles.clear();
+}
+
+/**
+ * Forget a single signal block, e.g. because it is being explored again.
+ * Its entry in #_signal_blocks is reused by the next explored block.
+ * @param id index of the block in #_signal_blocks
+ */
+static void ReleaseSignalBlock(uint id)
+{
+	SignalBlock &block = _signal_blocks[id];
+
+	for (uint64 key : block.nodes) {
+		auto it = _signal_block_nodes.find(key);
+		if (it != _signal_block_nodes.end() && it->second == id) _signal_block_nodes.erase(it);
+	}
+
+	for (TileIndex tile : block.tiles) {
+		auto it = _signal_block_tiles.find(tile);
+		assert(it != _signal_block_tiles.end());
+		std::vector<uint> &ids = it->second;
+		ids.erase(std::find(ids.begin(), ids.end(), id));
+		if (ids.empty()) _signal_block_tiles.erase(it);
+	}
+
+	block = {};
+	_free_signal_blocks.push_back(id);
+}
+
+/**
+ * Register a node as part of a signal block.
+ * A block that knew the node before overlaps with the new one and is released.
+ * @param key key of the node
+ * @param id index of the block in #_signal_blocks
+ */
+static void AddSignalBlockNode(uint64 key, uint id)
+{
+	auto it = _signal_block_nodes.find(key);
+	if (it != _signal_block_nodes.end()) {
+		if (it->second == id) return;
+		ReleaseSignalBlock(it->second);
+	}
+
+	_signal_block_nodes[key] = id;
+	_signal_blocks[id].nodes.push_back(key);
+}
+
+/** Reset all signal block data for a new game. */
+void InitializeSignals()
+{
+	InvalidateSignalBlocks();
+	_train_tile_count.clear();
+}
+
+/**
+ * Move a train vehicle between tiles in the occupancy counters of the signal blocks.
+ * @param from tile the vehicle was counted on, or INVALID_TILE
+ * @param to tile the vehicle is now counted on, or INVALID_TILE
+ */
+void MoveTrainInSignalBlocks(TileIndex from, TileIndex to)
+{
+	if (from != INVALID_TILE) {
+		auto count = _train_tile_count.find(from);
+		assert(count != _train_tile_count.end());
+		if (--count->second == 0) _train_tile_count.erase(count);
+
+		auto blocks = _signal_block_tiles.find(from);
+		if (blocks != _signal_block_tiles.end()) {
+			for (uint id : blocks->second) _signal_blocks[id].trains--;
+		}
+	}
+
+	if (to != INVALID_TILE) {
+		_train_tile_count[to]++;
+
+		auto blocks = _signal_block_tiles.find(to);
+		if (blocks != _signal_block_tiles.end()) {
+			for (uint id : blocks->second) _signal_blocks[id].trains++;
+		}
+	}
+}
+
+
 /**
  * Perform some operations before adding data into Todo set
- * The new and reverse direction is removed from _globset, because we are sure
- * it doesn't need to be checked again
- * Also, remove reverse direction from _tbdset
+ * Remove reverse direction from _tbdset
  * This is the 'core' part so the graph searching won't enter any tile twice
  *
  * @param t1 tile we are entering
@@ -211,9 +316,6 @@ static Vehicle *TrainOnTileEnum(Vehicle *v, void *)
  */
 static inline bool CheckAddToTodoSet(TileIndex t1, DiagDirection d1, TileIndex t2, DiagDirection d2)
 {
-	_globset.Remove(t1, d1); // it can be in Global but not in Todo
-	_globset.Remove(t2, d2); // remove in all cases
-
 	assert(!_tbdset.IsIn(t1, d1)); // it really shouldn't be there already
 
 	return !_tbdset.Remove(t2, d2);
@@ -222,8 +324,6 @@ static inline bool CheckAddToTodoSet(TileIndex t1, DiagDirection d1, TileIndex t
 
 /**
  * Perform some operations before adding data into Todo set
- * The new and reverse direction is removed from Global set, because we are sure
- * it doesn't need to be checked again
  * Also, remove reverse direction from Todo set
  * This is the 'core' part so the graph searching won't enter any tile twice
  *
@@ -231,13 +331,18 @@ static inline bool CheckAddToTodoSet(TileIndex t1, DiagDirection d1, TileIndex t
  * @param d1 direction (tile side) we are entering
  * @param t2 tile we are leaving
  * @param d2 direction (tile side) we are leaving
- * @return false iff the Todo buffer would be overrun
+ * @param owner owner whose signals we are updating
+ * @param id index of the block being explored in #_signal_blocks
  */
-static inline bool MaybeAddToTodoSet(TileIndex t1, DiagDirection d1, TileIndex t2, DiagDirection d2)
+static inline void MaybeAddToTodoSet(TileIndex t1, DiagDirection d1, TileIndex t2, DiagDirection d2, Owner owner, uint id)
 {
-	if (!CheckAddToTodoSet(t1, d1, t2, d2)) return true;
-
-	return _tbdset.Add(t1, d1);
+	if (CheckAddToTodoSet(t1, d1, t2, d2)) {
+		_tbdset.Add(t1, d1);
+	} else {
+		/* Two frontiers met; neither node is explored, but both are part of the block. */
+		AddSignalBlockNode(SignalNodeKey(t1, d1, owner), id);
+		AddSignalBlockNode(SignalNodeKey(t2, d2, owner), id);
+	}
 }
 
 
@@ -249,7 +354,6 @@ enum SigFlags {
 	SF_EXIT2  = 1 << 2, ///< two or more exits found
 	SF_GREEN  = 1 << 3, ///< green exitsignal found
 	SF_GREEN2 = 1 << 4, ///< two or more green exits found
-	SF_FULL   = 1 << 5, ///< some of buffers was full, do not continue
 	SF_PBS    = 1 << 6, ///< pbs signal found
 };
 
@@ -257,19 +361,31 @@ DECLARE_ENUM_AS_BIT_SET(SigFlags)
 
 
 /**
- * Search signal block
+ * Search signal block starting at the nodes in _tbdset and remember it.
  *
  * @param owner owner whose signals we are updating
- * @return SigFlags
+ * @return index of the new block in _signal_blocks
  */
-static SigFlags ExploreSegment(Owner owner)
+static uint ExploreSegment(Owner owner)
 {
-	SigFlags flags = SF_NONE;
+	uint id;
+	if (_free_signal_blocks.empty()) {
+		id = (uint)_signal_blocks.size();
+		_signal_blocks.emplace_back();
+	} else {
+		id = _free_signal_blocks.back();
+		_free_signal_blocks.pop_back();
+	}
+	SignalBlock &block = _signal_blocks[id];
+	block.owner = owner;
+	block.pbs = false;
 
 	TileIndex tile = INVALID_TILE; // Stop GCC from complaining about a possibly uninitialized variable (issue #8280).
 	DiagDirection enterdir = INVALID_DIAGDIR;
 
 	while (_tbdset.Get(&tile, &enterdir)) { // tile and enterdir are initialized here, unless I'm mistaken.
+		AddSignalBlockNode(SignalNodeKey(tile, enterdir, owner), id);
+
 		TileIndex oldtile = tile; // tile we are leaving
 		DiagDirection exitdir = enterdir == INVALID_DIAGDIR ? INVALID_DIAGDIR : ReverseDiagDir(enterdir); // expected new exit direction (for straight line)
 
@@ -279,13 +395,13 @@ static SigFlags ExploreSegment(Owner owner)
 
 				if (IsRailDepot(tile)) {
 					if (enterdir == INVALID_DIAGDIR) { // from 'inside' - train just entered or left the depot
-						if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, nullptr, &TrainOnTileEnum)) flags |= SF_TRAIN;
+						block.probes.push_back({tile, TRACK_BIT_NONE});
 						exitdir = GetRailDepotDirection(tile);
 						tile += TileOffsByDiagDir(exitdir);
 						enterdir = ReverseDiagDir(exitdir);
 						break;
 					} else if (enterdir == GetRailDepotDirection(tile)) { // entered a depot
-						if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, nullptr, &TrainOnTileEnum)) flags |= SF_TRAIN;
+						block.probes.push_back({tile, TRACK_BIT_NONE});
 						continue;
 					} else {
 						continue;
@@ -298,11 +414,10 @@ static SigFlags ExploreSegment(Owner owner)
 
 				if (tracks == TRACK_BIT_HORZ || tracks == TRACK_BIT_VERT) { // there is exactly one incidating track, no need to check
 					tracks = tracks_masked;
-					/* If no train detected yet, and there is not no train -> there is a train -> set the flag */
-					if (!(flags & SF_TRAIN) && EnsureNoTrainOnTrackBits(tile, tracks).Failed()) flags |= SF_TRAIN;
+					block.probes.push_back({tile, tracks});
 				} else {
 					if (tracks_masked == TRACK_BIT_NONE) continue; // no incidating track
-					if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, nullptr, &TrainOnTileEnum)) flags |= SF_TRAIN;
+					block.probes.push_back({tile, TRACK_BIT_NONE});
 				}
 
 				if (HasSignals(tile)) { // there is exactly one track - not zero, because there is exit from this tile
@@ -311,27 +426,20 @@ static SigFlags ExploreSegment(Owner owner)
 						SignalType sig = GetSignalType(tile, track);
 						Trackdir trackdir = (Trackdir)FindFirstBit((tracks * 0x101) & _enterdir_to_trackdirbits[enterdir]);
 						Trackdir reversedir = ReverseTrackdir(trackdir);
-						/* add (tile, reversetrackdir) to 'to-be-updated' set when there is
+						/* add (tile, reversetrackdir) to 'to-be-updated' list when there is
 						 * ANY conventional signal in REVERSE direction
 						 * (if it is a presignal EXIT and it changes, it will be added to 'to-be-done' set later) */
 						if (HasSignalOnTrackdir(tile, reversedir)) {
 							if (IsPbsSignal(sig)) {
-								flags |= SF_PBS;
-							} else if (!_tbuset.Add(tile, reversedir)) {
-								return flags | SF_FULL;
-							}
-						}
-						if (HasSignalOnTrackdir(tile, trackdir) && !IsOnewaySignal(tile, track)) flags |= SF_PBS;
-
-						/* if it is a presignal EXIT in OUR direction and we haven't found 2 green exits yes, do special check */
-						if (!(flags & SF_GREEN2) && IsPresignalExit(tile, track) && HasSignalOnTrackdir(tile, trackdir)) { // found presignal exit
-							if (flags & SF_EXIT) flags |= SF_EXIT2; // found two (or more) exits
-							flags |= SF_EXIT; // found at least one exit - allow for compiler optimizations
-							if (GetSignalStateByTrackdir(tile, trackdir) == SIGNAL_STATE_GREEN) { // found green presignal exit
-								if (flags & SF_GREEN) flags |= SF_GREEN2;
-								flags |= SF_GREEN;
+								block.pbs = true;
+							} else {
+								block.signals.push_back({tile, reversedir});
 							}
 						}
+						if (HasSignalOnTrackdir(tile, trackdir) && !IsOnewaySignal(tile, track)) block.pbs = true;
+
+						/* if it is a presignal EXIT in OUR direction, its state matters for the entries */
+						if (IsPresignalExit(tile, track) && HasSignalOnTrackdir(tile, trackdir)) block.exits.push_back({tile, trackdir});
 
 						continue;
 					}
@@ -341,7 +449,7 @@ static SigFlags ExploreSegment(Owner owner)
 					if (dir != enterdir && (tracks & _enterdir_to_trackbits[dir])) { // any track incidating?
 						TileIndex newtile = tile + TileOffsByDiagDir(dir);  // new tile to check
 						DiagDirection newdir = ReverseDiagDir(dir); // direction we are entering from
-						if (!MaybeAddToTodoSet(newtile, newdir, tile, dir)) return flags | SF_FULL;
+						MaybeAddToTodoSet(newtile, newdir, tile, dir, owner, id);
 					}
 				}
 
@@ -354,7 +462,7 @@ static SigFlags ExploreSegment(Owner owner)
 				if (DiagDirToAxis(enterdir) != GetRailStationAxis(tile)) continue; // different axis
 				if (IsStationTileBlocked(tile)) continue; // 'eye-candy' station tile
 
-				if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, nullptr, &TrainOnTileEnum)) flags |= SF_TRAIN;
+				block.probes.push_back({tile, TRACK_BIT_NONE});
 				tile += TileOffsByDiagDir(exitdir);
 				break;
 
@@ -363,7 +471,7 @@ static SigFlags ExploreSegment(Owner owner)
 				if (GetTileOwner(tile) != owner) continue;
 				if (DiagDirToAxis(enterdir) == GetCrossingRoadAxis(tile)) continue; // different axis
 
-				if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, nullptr, &TrainOnTileEnum)) flags |= SF_TRAIN;
+				block.probes.push_back({tile, TRACK_BIT_NONE});
 				tile += TileOffsByDiagDir(exitdir);
 				break;
 
@@ -373,13 +481,13 @@ static SigFlags ExploreSegment(Owner owner)
 				DiagDirection dir = GetTunnelBridgeDirection(tile);
 
 				if (enterdir == INVALID_DIAGDIR) { // incoming from the wormhole
-					if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, nullptr, &TrainOnTileEnum)) flags |= SF_TRAIN;
+					block.probes.push_back({tile, TRACK_BIT_NONE});
 					enterdir = dir;
 					exitdir = ReverseDiagDir(dir);
 					tile += TileOffsByDiagDir(exitdir); // just skip to next tile
 				} else { // NOT incoming from the wormhole!
 					if (ReverseDiagDir(enterdir) != dir) continue;
-					if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, nullptr, &TrainOnTileEnum)) flags |= SF_TRAIN;
+					block.probes.push_back({tile, TRACK_BIT_NONE});
 					tile = GetOtherTunnelBridgeEnd(tile); // just skip to exit tile
 					enterdir = INVALID_DIAGDIR;
 					exitdir = INVALID_DIAGDIR;
@@ -391,7 +499,81 @@ static SigFlags ExploreSegment(Owner owner)
 				continue; // continue the while() loop
 		}
 
-		if (!MaybeAddToTodoSet(tile, enterdir, oldtile, exitdir)) return flags | SF_FULL;
+		MaybeAddToTodoSet(tile, enterdir, oldtile, exitdir, owner, id);
+	}
+
+	/* Update the signals in a fixed order, so the result does not depend on where the block was entered. */
+	std::sort(block.signals.begin(), block.signals.end());
+
+	for (const SignalBlock::Probe &probe : block.probes) block.tiles.push_back(probe.tile);
+	std::sort(block.tiles.begin(), block.tiles.end());
+	block.tiles.erase(std::unique(block.tiles.begin(), block.tiles.end()), block.tiles.end());
+
+	block.trains = 0;
+	for (TileIndex tile : block.tiles) {
+		_signal_block_tiles[tile].push_back(id);
+		auto count = _train_tile_count.find(tile);
+		if (count != _train_tile_count.end()) block.trains += count->second;
+	}
+
+	return id;
+}
+
+
+/**
+ * Find a known signal block containing all nodes in _tbdset.
+ * @param owner owner whose signals we are updating
+ * @return index of the block in _signal_blocks, or UINT_MAX when the block has to be explored
+ */
+static uint FindSignalBlock(Owner owner)
+{
+	uint id = UINT_MAX;
+
+	for (const auto &node : _tbdset) {
+		auto it = _signal_block_nodes.find(SignalNodeKey(node.tile, node.dir, owner));
+		if (it == _signal_block_nodes.end()) return UINT_MAX;
+		if (id != UINT_MAX && id != it->second) return UINT_MAX;
+		id = it->second;
+	}
+
+	assert(id == UINT_MAX || _signal_blocks[id].owner == owner);
+	return id;
+}
+
+
+/**
+ * Determine the current state of a signal block
+ *
+ * @param block the block to check
+ * @return SigFlags
+ */
+static SigFlags GetSignalBlockFlags(const SignalBlock &block)
+{
+	SigFlags flags = block.pbs ? SF_PBS : SF_NONE;
+
+	/* Only look at the tiles when at least one train vehicle is counted on them. */
+	if (block.trains != 0) {
+		for (const SignalBlock::Probe &probe : block.probes) {
+			bool found = probe.tracks == TRACK_BIT_NONE ?
+					HasVehicleOnPos(probe.tile, nullptr, &TrainOnTileEnum) :
+					EnsureNoTrainOnTrackBits(probe.tile, probe.tracks).Failed();
+			if (found) {
+				flags |= SF_TRAIN;
+				break;
+			}
+		}
+	}
+
+	for (const SignalBlock::Signal &exit : block.exits) {
+		if (flags & SF_EXIT) flags |= SF_EXIT2; // found two (or more) exits
+		flags |= SF_EXIT; // found at least one exit - allow for compiler optimizations
+		if (GetSignalStateByTrackdir(exit.tile, exit.trackdir) == SIGNAL_STATE_GREEN) { // found green presignal exit
+			if (flags & SF_GREEN) {
+				flags |= SF_GREEN2;
+				break;
+			}
+			flags |= SF_GREEN;
+		}
 	}
 
 	return flags;
@@ -399,16 +581,16 @@ static SigFlags ExploreSegment(Owner owner)
 
 
 /**
- * Update signals around segment in _tbuset
+ * Update signals around a signal block
  *
+ * @param block the signal block
  * @param flags info about segment
  */
-static void UpdateSignalsAroundSegment(SigFlags flags)
+static void UpdateSignalsAroundSegment(const SignalBlock &block, SigFlags flags)
 {
-	TileIndex tile = INVALID_TILE; // Stop GCC from complaining about a possibly uninitialized variable (issue #8280).
-	Trackdir trackdir = INVALID_TRACKDIR;
-
-	while (_tbuset.Get(&tile, &trackdir)) {
+	for (const SignalBlock::Signal &signal : block.signals) {
+		TileIndex tile = signal.tile;
+		Trackdir trackdir = signal.trackdir;
 		assert(HasSignalOnTrackdir(tile, trackdir));
 
 		SignalType sig = GetSignalType(tile, TrackdirToTrack(trackdir));
@@ -439,7 +621,7 @@ static void UpdateSignalsAroundSegment(SigFlags flags)
 			if (IsPresignalExit(tile, TrackdirToTrack(trackdir))) {
 				/* for pre-signal exits, add block to the global set */
 				DiagDirection exitdir = TrackdirToExitdir(ReverseTrackdir(trackdir));
-				_globset.Add(tile, exitdir); // do not check for full global set, first update all signals
+				_globset.Add(tile, exitdir); // first update all signals
 			}
 			SetSignalStateByTrackdir(tile, trackdir, newstate);
 			MarkTileDirtyByTile(tile);
@@ -449,15 +631,6 @@ static void UpdateSignalsAroundSegment(SigFlags flags)
 }
 
 
-/** Reset all sets after one set overflowed */
-static inline void ResetSets()
-{
-	_tbuset.Reset();
-	_tbdset.Reset();
-	_globset.Reset();
-}
-
-
 /**
  * Updates blocks in _globset buffer
  *
@@ -476,7 +649,6 @@ static SigSegState UpdateSignalsInBuffer(Owner owner)
 	DiagDirection dir = INVALID_DIAGDIR;
 
 	while (_globset.Get(&tile, &dir)) {
-		assert(_tbuset.IsEmpty());
 		assert(_tbdset.IsEmpty());
 
 		/* After updating signal, data stored are always MP_RAILWAY with signals.
@@ -524,28 +696,29 @@ static SigSegState UpdateSignalsInBuffer(Owner owner)
 				continue; // continue the while() loop
 		}
 
-		assert(!_tbdset.Overflowed()); // it really shouldn't overflow by these one or two items
 		assert(!_tbdset.IsEmpty()); // it wouldn't hurt anyone, but shouldn't happen too
 
-		SigFlags flags = ExploreSegment(owner);
+		uint id = FindSignalBlock(owner);
+		if (id == UINT_MAX) {
+			id = ExploreSegment(owner);
+		} else {
+			_tbdset.Reset();
+		}
+
+		const SignalBlock &block = _signal_blocks[id];
+		SigFlags flags = GetSignalBlockFlags(block);
 
 		if (first) {
 			first = false;
 			/* SIGSEG_FREE is set by default */
 			if (flags & SF_PBS) {
 				state = SIGSEG_PBS;
-			} else if ((flags & SF_TRAIN) || ((flags & SF_EXIT) && !(flags & SF_GREEN)) || (flags & SF_FULL)) {
+			} else if ((flags & SF_TRAIN) || ((flags & SF_EXIT) && !(flags & SF_GREEN))) {
 				state = SIGSEG_FULL;
 			}
 		}
 
-		/* do not do anything when some buffer was full */
-		if (flags & SF_FULL) {
-			ResetSets(); // free all sets
-			break;
-		}
-
-		UpdateSignalsAroundSegment(flags);
+		UpdateSignalsAroundSegment(block, flags);
 	}
 
 	return state;
@@ -569,13 +742,13 @@ void UpdateSignalsInBuffer()
 
 
 /**
- * Add track to signal update buffer
+ * Add both ends of a track to the signal update buffer, without changing the layout.
  *
  * @param tile tile where we start
  * @param track track at which ends we will update signals
  * @param owner owner whose signals we will update
  */
-void AddTrackToSignalBuffer(TileIndex tile, Track track, Owner owner)
+static void AddTrackToBuffer(TileIndex tile, Track track, Owner owner)
 {
 	static const DiagDirection _search_dir_1[] = {
 		DIAGDIR_NE, DIAGDIR_SE, DIAGDIR_NE, DIAGDIR_SE, DIAGDIR_SW, DIAGDIR_SE
@@ -600,8 +773,24 @@ void AddTrackToSignalBuffer(TileIndex tile, Track track, Owner owner)
 }
 
 
+/**
+ * Add track to signal update buffer
+ * The track layout at \a tile is assumed to have changed.
+ *
+ * @param tile tile where we start
+ * @param track track at which ends we will update signals
+ * @param owner owner whose signals we will update
+ */
+void AddTrackToSignalBuffer(TileIndex tile, Track track, Owner owner)
+{
+	InvalidateSignalBlocks();
+	AddTrackToBuffer(tile, track, owner);
+}
+
+
 /**
  * Add side of tile to signal update buffer
+ * The track layout at \a tile is assumed to have changed.
  *
  * @param tile tile where we start
  * @param side side of tile
@@ -612,6 +801,8 @@ void AddSideToSignalBuffer(TileIndex tile, DiagDirection side, Owner owner)
 	/* do not allow signal updates for two companies in one run */
 	assert(_globset.IsEmpty() || owner == _last_owner);
 
+	InvalidateSignalBlocks();
+
 	_last_owner = owner;
 
 	_globset.Add(tile, side);
@@ -655,6 +846,6 @@ void SetSignalsOnBothDir(TileIndex tile, Track track, Owner owner)
 {
 	assert(_globset.IsEmpty());
 
-	AddTrackToSignalBuffer(tile, track, owner);
+	AddTrackToBuffer(tile, track, owner);
 	UpdateSignalsInBuffer(owner);
 }
@@ -739,87 +739,188 @@ void SmallMapWindow::SetZoomLevel(ZoomLevelChange change, const Point *zoom_pt)
 	}
 }
 
+/** Importance of a tile of an industry that is shown in its own colour in the "Industries" mode, see #_tiletype_importance. */
+static const uint8 SMALLMAP_IMPORTANCE_INDUSTRY = 10;
+/** Flag for the importance of a tile of the highlighted industry type in the "Industries" mode; its colour blinks. */
+static const uint8 SMALLMAP_IMPORTANCE_HIGHLIGHT = 0x80;
+/** Importance of a tile of which the colour is not cached. */
+static const uint8 SMALLMAP_IMPORTANCE_INVALID = 0xFF;
+
 /**
- * Decide which colours to show to the user for a group of tiles.
- * @param ta Tile area to investigate.
- * @return Colours to display.
+ * Cached colours of the individual tiles in the small map, for the current
+ * mode. They are updated when a tile is marked dirty, so redrawing the small
+ * map only has to look them up.
  */
-inline uint32 SmallMapWindow::GetTileColours(const TileArea &ta) const
+static struct SmallMapTileCache {
+	std::vector<uint32> colours;   ///< Colours of each tile.
+	std::vector<uint8> importance; ///< Importance of each tile, see #_tiletype_importance, or #SMALLMAP_IMPORTANCE_INVALID.
+	std::vector<uint8> state;      ///< Settings and legends the cached colours were determined with.
+} _smallmap_tile_cache;
+
+/**
+ * Mark the cached small map colour of a tile as outdated.
+ * @param tile The tile that changed.
+ */
+void MarkSmallMapTileDirty(TileIndex tile)
 {
-	int importance = 0;
-	TileIndex tile = INVALID_TILE; // Position of the most important tile.
-	TileType et = MP_VOID;         // Effective tile type at that position.
+	if (tile < _smallmap_tile_cache.importance.size()) _smallmap_tile_cache.importance[tile] = SMALLMAP_IMPORTANCE_INVALID;
+}
 
-	for (TileIndex ti : ta) {
-		TileType ttype = (TileType)tile_map.get(ti).type;
+/** Mark the cached small map colours of all tiles as outdated. */
+void InvalidateSmallMapTiles()
+{
+	_smallmap_tile_cache.state.clear();
+}
+
+/**
+ * Make sure the tile colour cache matches the map and the current mode,
+ * settings and legends of the small map.
+ */
+void SmallMapWindow::UpdateTileCache() const
+{
+	/* Everything besides the tiles themselves the colours depend on. */
+	std::vector<uint8> state;
+	auto add = [&state](uint32 value) {
+		for (uint i = 0; i < 4; i++) state.push_back(GB(value, i * 8, 8));
+	};
+	add(this->map_type);
+	add(_settings_client.gui.smallmap_land_colour);
+	add(_smallmap_show_heightmap);
+	add(SmallMapWindow::map_height_limit);
+	if (this->map_type == SMT_INDUSTRY) {
+		add(_smallmap_industry_highlight);
+		for (int i = 0; i < _smallmap_industry_count; i++) state.push_back(_legend_from_industries[i].show_on_map);
+	}
+	if (this->map_type == SMT_OWNER) {
+		for (int i = 0; !_legend_land_owners[i].end; i++) {
+			state.push_back(_legend_land_owners[i].company);
+			state.push_back(_legend_land_owners[i].show_on_map);
+			state.push_back(_legend_land_owners[i].colour);
+		}
+	}
 
-		switch (ttype) {
-			case MP_TUNNELBRIDGE: {
-				TransportType tt = GetTunnelBridgeTransportType(ti);
+	SmallMapTileCache &cache = _smallmap_tile_cache;
+	if (cache.state == state && cache.importance.size() == tile_map.size) return;
 
-				switch (tt) {
-					case TRANSPORT_RAIL: ttype = MP_RAILWAY; break;
-					case TRANSPORT_ROAD: ttype = MP_ROAD;    break;
-					default:             ttype = MP_WATER;   break;
-				}
-				break;
+	cache.state = std::move(state);
+	cache.colours.resize(tile_map.size);
+	cache.importance.assign(tile_map.size, SMALLMAP_IMPORTANCE_INVALID);
+}
+
+/**
+ * Decide which colour to show to the user for a single tile.
+ * @param tile Tile to investigate.
+ * @param[out] importance How interesting the tile is to show when it is grouped with other tiles.
+ * @return Colours to display.
+ */
+uint32 SmallMapWindow::GetTileColour(TileIndex tile, uint8 *importance) const
+{
+	TileType ttype = (TileType)tile_map.get(tile).type;
+
+	switch (ttype) {
+		case MP_TUNNELBRIDGE: {
+			TransportType tt = GetTunnelBridgeTransportType(tile);
+
+			switch (tt) {
+				case TRANSPORT_RAIL: ttype = MP_RAILWAY; break;
+				case TRANSPORT_ROAD: ttype = MP_ROAD;    break;
+				default:             ttype = MP_WATER;   break;
 			}
+			break;
+		}
 
-			case MP_INDUSTRY:
-				/* Special handling of industries while in "Industries" smallmap view. */
-				if (this->map_type == SMT_INDUSTRY) {
-					/* If industry is allowed to be seen, use its colour on the map.
-					 * This has the highest priority above any value in _tiletype_importance. */
-					IndustryType type = Industry::GetByTile(ti)->type;
-					if (_legend_from_industries[_industry_to_list_pos[type]].show_on_map) {
-						if (type == _smallmap_industry_highlight) {
-							if (_smallmap_industry_highlight_state) return MKCOLOUR_XXXX(PC_WHITE);
-						} else {
-							return GetIndustrySpec(type)->map_colour * 0x01010101;
-						}
+		case MP_INDUSTRY:
+			/* Special handling of industries while in "Industries" smallmap view. */
+			if (this->map_type == SMT_INDUSTRY) {
+				/* If industry is allowed to be seen, use its colour on the map.
+				 * This has the highest priority above any value in _tiletype_importance. */
+				IndustryType type = Industry::GetByTile(tile)->type;
+				if (_legend_from_industries[_industry_to_list_pos[type]].show_on_map) {
+					if (type == _smallmap_industry_highlight) {
+						/* Blinks between white and the normal industry tile colour. */
+						*importance = _tiletype_importance[MP_INDUSTRY] | SMALLMAP_IMPORTANCE_HIGHLIGHT;
+						return GetSmallMapIndustriesPixels(tile, MP_INDUSTRY);
 					}
-					/* Otherwise make it disappear */
-					ttype = IsTileOnWater(ti) ? MP_WATER : MP_CLEAR;
+					*importance = SMALLMAP_IMPORTANCE_INDUSTRY;
+					return GetIndustrySpec(type)->map_colour * 0x01010101;
 				}
-				break;
-
-			default:
-				break;
-		}
+				/* Otherwise make it disappear */
+				ttype = IsTileOnWater(tile) ? MP_WATER : MP_CLEAR;
+			}
+			break;
 
-		if (_tiletype_importance[ttype] > importance) {
-			importance = _tiletype_importance[ttype];
-			tile = ti;
-			et = ttype;
-		}
+		default:
+			break;
 	}
 
+	*importance = _tiletype_importance[ttype];
+
 	switch (this->map_type) {
 		case SMT_CONTOUR:
-			return GetSmallMapContoursPixels(tile, et);
+			return GetSmallMapContoursPixels(tile, ttype);
 
 		case SMT_VEHICLES:
-			return GetSmallMapVehiclesPixels(tile, et);
+			return GetSmallMapVehiclesPixels(tile, ttype);
 
 		case SMT_INDUSTRY:
-			return GetSmallMapIndustriesPixels(tile, et);
+			return GetSmallMapIndustriesPixels(tile, ttype);
 
 		case SMT_LINKSTATS:
-			return GetSmallMapLinkStatsPixels(tile, et);
+			return GetSmallMapLinkStatsPixels(tile, ttype);
 
 		case SMT_ROUTES:
-			return GetSmallMapRoutesPixels(tile, et);
+			return GetSmallMapRoutesPixels(tile, ttype);
 
 		case SMT_VEGETATION:
-			return GetSmallMapVegetationPixels(tile, et);
+			return GetSmallMapVegetationPixels(tile, ttype);
 
 		case SMT_OWNER:
-			return GetSmallMapOwnerPixels(tile, et);
+			return GetSmallMapOwnerPixels(tile, ttype);
 
 		default: NOT_REACHED();
 	}
 }
 
+/**
+ * Decide which colours to show to the user for a group of tiles.
+ * The most important tile of the group determines the colours; of equally
+ * important tiles the first one does.
+ * @param ta Tile area to investigate.
+ * @return Colours to display.
+ * @pre The tile cache is up to date, see #UpdateTileCache.
+ */
+inline uint32 SmallMapWindow::GetTileColours(const TileArea &ta) const
+{
+	SmallMapTileCache &cache = _smallmap_tile_cache;
+	uint8 best = 0;
+	uint32 colours = 0;
+
+	for (TileIndex ti : ta) {
+		uint8 importance = cache.importance[ti];
+		if (importance == SMALLMAP_IMPORTANCE_INVALID) {
+			cache.colours[ti] = this->GetTileColour(ti, &importance);
+			cache.importance[ti] = importance;
+		}
+
+		uint32 c = cache.colours[ti];
+		if (importance & SMALLMAP_IMPORTANCE_HIGHLIGHT) {
+			if (_smallmap_industry_highlight_state) {
+				importance = SMALLMAP_IMPORTANCE_INDUSTRY;
+				c = MKCOLOUR_XXXX(PC_WHITE);
+			} else {
+				importance &= ~SMALLMAP_IMPORTANCE_HIGHLIGHT;
+			}
+		}
+
+		if (importance > best) {
+			best = importance;
+			colours = c;
+		}
+	}
+
+	return colours;
+}
+
 /**
  * Draws one column of tiles of the small map in a certain mode onto the screen buffer, skipping the shifted rows in between.
  *
@@ -977,6 +1078,8 @@ void SmallMapWindow::DrawSmallMap(DrawPixelInfo *dpi) const
 	/* Clear it */
 	GfxFillRect(dpi->left, dpi->top, dpi->left + dpi->width - 1, dpi->top + dpi->height - 1, PC_BLACK);
 
+	this->UpdateTileCache();
+
 	/* Which tile is displayed at (dpi->left, dpi->top)? */
 	int dx;
 	Point tile = this->PixelToTile(dpi->left, dpi->top, &dx);
@@ -1095,6 +1198,9 @@ SmallMapWindow::SmallMapWindow(WindowDesc *desc, int window_number) : Window(des
 SmallMapWindow::~SmallMapWindow()
 {
 	delete this->overlay;
+
+	/* Only keep the tile colours while the small map is open. */
+	_smallmap_tile_cache = {};
 }
 
 /* virtual */ void SmallMapWindow::Close()
@@ -26,6 +26,8 @@ void BuildIndustriesLegend();
 void ShowSmallMap();
 void BuildLandLegend();
 void BuildOwnerLegend();
+void MarkSmallMapTileDirty(TileIndex tile);
+void InvalidateSmallMapTiles();
 
 /** Structure for holding relevant data for legends in small map */
 struct LegendAndColour {
@@ -165,6 +167,8 @@ protected:
 	void SetZoomLevel(ZoomLevelChange change, const Point *zoom_pt);
 	void SetOverlayCargoMask();
 	void SetupWidgetData();
+	void UpdateTileCache() const;
+	uint32 GetTileColour(TileIndex tile, uint8 *importance) const;
 	uint32 GetTileColours(const TileArea &ta) const;
 
 	int GetPositionOnLegend(Point pt);
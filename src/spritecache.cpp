@@ -18,22 +18,32 @@
 #include "core/math_func.hpp"
 #include "core/mem_func.hpp"
 #include "video/video_driver.hpp"
+#include "thread.h"
+#include "fileio_func.h"
+#include "string_func.h"
+#include "rev.h"
+#include "3rdparty/md5/md5.h"
 
 #include "table/sprites.h"
 #include "table/strings.h"
 #include "table/palette_convert.h"
 
+#include <condition_variable>
+#include <deque>
+
 #include "safeguards.h"
 
 /* Default of 4MB spritecache */
 uint _sprite_cache_size = 4;
+bool _sprite_disk_cache = false; ///< Whether encoded sprites are also kept in a cache on disk.
 
 struct SpriteCache {
 	void *ptr;
 	size_t file_pos;
 	SpriteFile *file;    ///< The file the sprite in this entry can be found in.
 	uint32 id;
-	int16 lru;
+	SpriteID lru_prev;   ///< More recently used cached sprite, or #INVALID_LRU_SPRITE.
+	SpriteID lru_next;   ///< Less recently used cached sprite, or #INVALID_LRU_SPRITE.
 	SpriteType type;     ///< In some cases a single sprite is misused by two NewGRFs. Once as real sprite and once as recolour sprite. If the recolour sprite gets into the cache it might be drawn as real sprite which causes enormous trouble.
 	bool warned;         ///< True iff the user has been warned about incorrect use of this sprite
 	byte control_flags;  ///< Control flags, see SpriteCacheCtrlFlags
@@ -104,17 +114,23 @@ SpriteFile &OpenCachedSpriteFile(const std::string &filename, Subdirectory subdi
 	return *file;
 }
 
+/** Header in front of every block of memory in the sprite cache. */
 struct MemBlock {
-	size_t size;
+	uint32 size; ///< Requested size of the block, including this header.
+	uint32 slab; ///< Slab the block is part of, or #INVALID_SLAB for blocks that are allocated on their own.
 	byte data[];
 };
 
-static uint _sprite_lru_counter;
-static MemBlock *_spritecache_ptr;
-static uint _allocated_sprite_cache_size = 0;
-static int _compact_cache_counter;
+static size_t _allocated_sprite_cache_size = 0; ///< Maximum amount of memory the sprite cache may use.
+static size_t _sprite_cache_allocated = 0;      ///< Memory held by the sprite cache, including unused slab blocks.
+static size_t _sprite_cache_requested = 0;      ///< Memory requested for the blocks in the sprite cache.
+static uint64 _sprite_cache_hits = 0;           ///< Number of sprite requests that were served from the cache.
+static uint64 _sprite_cache_misses = 0;         ///< Number of sprite requests that needed the sprite to be loaded.
+static uint64 _sprite_cache_evictions = 0;      ///< Number of sprites removed from the cache to make space.
+
+static std::mutex _sprite_file_lock; ///< Serialises reading from the sprite files.
 
-static void CompactSpriteCache();
+static void DeleteEntryFromSpriteCache(uint item);
 static void *AllocSprite(size_t mem_req);
 
 /**
@@ -442,6 +458,224 @@ static void *ReadRecolourSprite(SpriteFile &file, uint num)
 	return dest;
 }
 
+/** Header of a single sprite in a sprite disk cache file. */
+struct SpriteDiskCacheRecord {
+	uint64 file_pos;     ///< Position of the sprite in the sprite file.
+	uint32 size;         ///< Size of the encoded sprite following this header.
+	byte control_flags;  ///< Control flags the sprite was loaded with, see SpriteCacheCtrlFlags.
+	byte padding[3];     ///< Unused, written as zero.
+};
+
+/**
+ * The sprite disk cache of a single sprite file. The cache file holds the
+ * sprites in the format of the current blitter, after a header identifying
+ * everything the encoded sprites depend on; see #OpenSpriteDiskCache.
+ */
+struct SpriteDiskCache {
+	FILE *handle = nullptr;                                          ///< The cache file, or \c nullptr when not usable.
+	long end = 0;                                                    ///< End of the last complete record; new records are written here.
+	bool appending = false;                                          ///< Whether the last access was a write, so the position is already at #end.
+	std::map<std::pair<uint64, byte>, std::pair<long, uint32>> index; ///< Position and size of the data of each sprite, by file position and control flags.
+
+	~SpriteDiskCache()
+	{
+		if (this->handle != nullptr) fclose(this->handle);
+	}
+};
+
+static std::map<const SpriteFile *, SpriteDiskCache> _sprite_disk_caches; ///< Opened sprite disk caches, by sprite file.
+static ReusableBuffer<byte> _sprite_disk_cache_buffer; ///< Buffer for reading sprites from the disk caches.
+
+/**
+ * Calculate the MD5 sum of the whole sprite file. The MD5 sum a sprite file is
+ * known by only covers the data section of container version 2 files, so it
+ * does not change when only their sprites change.
+ * @param file The sprite file.
+ * @return The MD5 sum as string.
+ * @pre #_sprite_file_lock is held.
+ */
+static std::string CalcSpriteFileMD5Sum(SpriteFile &file)
+{
+	Md5 checksum;
+	byte buffer[1024];
+
+	file.SeekTo(file.GetStartPos(), SEEK_SET);
+	for (size_t left = file.GetEndPos() - file.GetStartPos(); left != 0;) {
+		size_t len = std::min(left, sizeof(buffer));
+		file.ReadBlock(buffer, len);
+		checksum.Append(buffer, len);
+		left -= len;
+	}
+
+	uint8 digest[16];
+	checksum.Finish(digest);
+	char md5sum[33];
+	md5sumToString(md5sum, lastof(md5sum), digest);
+	return md5sum;
+}
+
+/**
+ * Get the sprite disk cache of a sprite file, opening it if needed.
+ * A cache file whose header does not match the current revision, blitter,
+ * palette remapping, size and content of the sprite file and sprite settings
+ * is started anew.
+ * Sprite files that are remapped have their own cache file, so switching
+ * the palette of a NewGRF back and forth does not throw away the cache.
+ * @param file The sprite file.
+ * @return The cache; its handle is \c nullptr if there is no usable cache for the file.
+ * @pre #_sprite_file_lock is held.
+ */
+static SpriteDiskCache &OpenSpriteDiskCache(SpriteFile &file)
+{
+	auto it = _sprite_disk_caches.find(&file);
+	if (it != _sprite_disk_caches.end()) return it->second;
+
+	SpriteDiskCache &cache = _sprite_disk_caches[&file];
+	if (file.GetMD5Sum() == nullptr || _personal_dir.empty()) return cache;
+
+	const char *blitter = BlitterFactory::GetCurrentBlitter()->GetName();
+	const char *palette = file.NeedsPaletteRemap() ? "remap" : "native";
+	std::string header = fmt::format("OTTD sprite cache\n{}\n{}\n{}\n{}\n{}\n{}\n", _openttd_revision, blitter, palette, (int)_settings_client.gui.sprite_zoom_min,
+			file.GetEndPos() - file.GetStartPos(), CalcSpriteFileMD5Sum(file));
+
+	char md5sum[33];
+	md5sumToString(md5sum, lastof(md5sum), file.GetMD5Sum());
+	std::string dir = _personal_dir + "cache" PATHSEP;
+	FioCreateDirectory(dir);
+	dir += "sprites" PATHSEP;
+	FioCreateDirectory(dir);
+	std::string filename = fmt::format("{}{}-{}-{}.dat", dir, md5sum, blitter, palette);
+
+	cache.handle = FioFOpenFile(filename, "r+b", NO_DIRECTORY);
+	if (cache.handle != nullptr) {
+		/* Check whether the cache was made for the same encoding of the sprites. */
+		std::string found(header.size(), '\0');
+		if (fread(&found[0], 1, found.size(), cache.handle) == found.size() && found == header) {
+			fseek(cache.handle, 0, SEEK_END);
+			long length = ftell(cache.handle);
+			cache.end = (long)header.size();
+			fseek(cache.handle, cache.end, SEEK_SET);
+
+			/* Index the records; stop at an incomplete one, it is overwritten later on. */
+			SpriteDiskCacheRecord record;
+			while (fread(&record, sizeof(record), 1, cache.handle) == 1) {
+				long data = cache.end + (long)sizeof(record);
+				if (data + (long)record.size > length) break;
+				cache.index[{ record.file_pos, record.control_flags }] = { data, record.size };
+				cache.end = data + record.size;
+				fseek(cache.handle, cache.end, SEEK_SET);
+			}
+
+			Debug(sprite, 2, "Using sprite disk cache '{}' with {} sprites", filename, cache.index.size());
+			return cache;
+		}
+		fclose(cache.handle);
+	}
+
+	/* Start a new cache file. */
+	cache.handle = FioFOpenFile(filename, "w+b", NO_DIRECTORY);
+	if (cache.handle == nullptr) return cache;
+	if (fwrite(header.data(), 1, header.size(), cache.handle) != header.size()) {
+		fclose(cache.handle);
+		cache.handle = nullptr;
+		return cache;
+	}
+	cache.end = (long)header.size();
+	Debug(sprite, 2, "Created sprite disk cache '{}'", filename);
+	return cache;
+}
+
+/**
+ * Load an encoded sprite from the sprite disk cache.
+ * @param file The sprite file of the sprite.
+ * @param file_pos The position of the sprite in the file.
+ * @param control_flags The control flags of the sprite.
+ * @param allocator Allocator function to use.
+ * @return The sprite, or \c nullptr when it is not in the cache.
+ */
+static void *LoadSpriteFromDiskCache(SpriteFile &file, size_t file_pos, byte control_flags, AllocatorProc *allocator)
+{
+	std::lock_guard<std::mutex> guard(_sprite_file_lock);
+	SpriteDiskCache &cache = OpenSpriteDiskCache(file);
+	if (cache.handle == nullptr) return nullptr;
+
+	auto it = cache.index.find({ file_pos, control_flags });
+	if (it == cache.index.end()) return nullptr;
+
+	/* Read the header of the record again, so data at another offset is never used as a sprite. */
+	uint32 size = it->second.second;
+	SpriteDiskCacheRecord record;
+	byte *buffer = _sprite_disk_cache_buffer.Allocate(size);
+	cache.appending = false;
+	if (fseek(cache.handle, it->second.first - (long)sizeof(record), SEEK_SET) != 0 || fread(&record, sizeof(record), 1, cache.handle) != 1) return nullptr;
+	if (record.file_pos != file_pos || record.control_flags != control_flags || record.size != size) return nullptr;
+	if (fread(buffer, 1, size, cache.handle) != size) return nullptr;
+
+	void *data = allocator(size);
+	memcpy(data, buffer, size);
+	return data;
+}
+
+/**
+ * Add an encoded sprite to the sprite disk cache.
+ * @param file The sprite file of the sprite.
+ * @param file_pos The position of the sprite in the file.
+ * @param control_flags The control flags of the sprite.
+ * @param data The encoded sprite.
+ * @param size The size of the encoded sprite.
+ */
+static void SaveSpriteToDiskCache(SpriteFile &file, size_t file_pos, byte control_flags, const void *data, size_t size)
+{
+	std::lock_guard<std::mutex> guard(_sprite_file_lock);
+	SpriteDiskCache &cache = OpenSpriteDiskCache(file);
+	if (cache.handle == nullptr) return;
+
+	SpriteDiskCacheRecord record = {};
+	record.file_pos = file_pos;
+	record.size = (uint32)size;
+	record.control_flags = control_flags;
+
+	/* Seeking flushes the buffered records, so only seek when something else was read since the last write. */
+	if ((!cache.appending && fseek(cache.handle, cache.end, SEEK_SET) != 0) ||
+			fwrite(&record, sizeof(record), 1, cache.handle) != 1 ||
+			fwrite(data, 1, size, cache.handle) != size) {
+		/* Most likely the disk is full; stop using this cache. */
+		fclose(cache.handle);
+		cache.handle = nullptr;
+		return;
+	}
+
+	cache.index[{ record.file_pos, record.control_flags }] = { cache.end + (long)sizeof(record), record.size };
+	cache.end += (long)(sizeof(record) + size);
+	cache.appending = true;
+}
+
+/**
+ * Close all sprite disk caches, e.g. because the sprite files or the blitter change.
+ * @pre No sprites are being prefetched.
+ */
+static void CloseSpriteDiskCaches()
+{
+	std::lock_guard<std::mutex> guard(_sprite_file_lock);
+	_sprite_disk_caches.clear();
+}
+
+/** Allocator to use for the sprite that is encoded for the sprite disk cache. */
+static thread_local AllocatorProc *_sprite_disk_cache_allocator;
+/** Size of the sprite that was encoded for the sprite disk cache. */
+static thread_local size_t _sprite_disk_cache_size;
+
+/**
+ * Allocator remembering the size of the sprite, so it can be stored in the sprite disk cache.
+ * @param size Size of the sprite.
+ * @return Memory for the sprite.
+ */
+static void *SpriteDiskCacheAlloc(size_t size)
+{
+	_sprite_disk_cache_size = size;
+	return _sprite_disk_cache_allocator(size);
+}
+
 /**
  * Read a sprite from disk.
  * @param sc          Location of sprite.
@@ -449,7 +683,8 @@ static void *ReadRecolourSprite(SpriteFile &file, uint num)
  * @param sprite_type Type of sprite.
  * @param allocator   Allocator function to use.
  * @param encoder     Sprite encoder to use.
- * @return Read sprite data.
+ * @return Read sprite data, or \c nullptr if the sprite could not be loaded.
+ * @note This is also called by the prefetch threads, so it must not touch the sprite cache.
  */
 static void *ReadSprite(const SpriteCache *sc, SpriteID id, SpriteType sprite_type, AllocatorProc *allocator, SpriteEncoder *encoder)
 {
@@ -465,23 +700,34 @@ static void *ReadSprite(const SpriteCache *sc, SpriteID id, SpriteType sprite_ty
 
 	Debug(sprite, 9, "Load sprite {}", id);
 
+	/* Only normal sprites of the current blitter are cached on disk; font sprites also depend on the font zoom. */
+	bool disk_cache = _sprite_disk_cache && sprite_type == ST_NORMAL && encoder == BlitterFactory::GetCurrentBlitter() && file.GetMD5Sum() != nullptr;
+	if (disk_cache) {
+		void *data = LoadSpriteFromDiskCache(file, file_pos, sc->control_flags, allocator);
+		if (data != nullptr) return data;
+	}
+
 	SpriteLoader::Sprite sprite[ZOOM_LVL_COUNT];
 	uint8 sprite_avail = 0;
 	sprite[ZOOM_LVL_NORMAL].type = sprite_type;
 
 	SpriteLoaderGrf sprite_loader(file.GetContainerVersion());
-	if (sprite_type != ST_MAPGEN && encoder->Is32BppSupported()) {
-		/* Try for 32bpp sprites first. */
-		sprite_avail = sprite_loader.LoadSprite(sprite, file, file_pos, sprite_type, true, sc->control_flags);
-	}
-	if (sprite_avail == 0) {
-		sprite_avail = sprite_loader.LoadSprite(sprite, file, file_pos, sprite_type, false, sc->control_flags);
+	{
+		/* The sprite files are shared with the prefetch threads. */
+		std::lock_guard<std::mutex> guard(_sprite_file_lock);
+		if (sprite_type != ST_MAPGEN && encoder->Is32BppSupported()) {
+			/* Try for 32bpp sprites first. */
+			sprite_avail = sprite_loader.LoadSprite(sprite, file, file_pos, sprite_type, true, sc->control_flags);
+		}
+		if (sprite_avail == 0) {
+			sprite_avail = sprite_loader.LoadSprite(sprite, file, file_pos, sprite_type, false, sc->control_flags);
+		}
 	}
 
 	if (sprite_avail == 0) {
 		if (sprite_type == ST_MAPGEN) return nullptr;
 		if (id == SPR_IMG_QUERY) usererror("Okay... something went horribly wrong. I couldn't load the fallback sprite. What should I do?");
-		return (void*)GetRawSprite(SPR_IMG_QUERY, ST_NORMAL, allocator, encoder);
+		return nullptr;
 	}
 
 	if (sprite_type == ST_MAPGEN) {
@@ -514,7 +760,7 @@ static void *ReadSprite(const SpriteCache *sc, SpriteID id, SpriteType sprite_ty
 
 	if (!ResizeSprites(sprite, sprite_avail, encoder)) {
 		if (id == SPR_IMG_QUERY) usererror("Okay... something went horribly wrong. I couldn't resize the fallback sprite. What should I do?");
-		return (void*)GetRawSprite(SPR_IMG_QUERY, ST_NORMAL, allocator, encoder);
+		return nullptr;
 	}
 
 	if (sprite->type == ST_FONT && ZOOM_LVL_FONT != ZOOM_LVL_NORMAL) {
@@ -527,7 +773,12 @@ static void *ReadSprite(const SpriteCache *sc, SpriteID id, SpriteType sprite_ty
 		sprite[ZOOM_LVL_NORMAL].colours = sprite[ZOOM_LVL_FONT].colours;
 	}
 
-	return encoder->Encode(sprite, allocator);
+	if (!disk_cache) return encoder->Encode(sprite, allocator);
+
+	_sprite_disk_cache_allocator = allocator;
+	Sprite *s = encoder->Encode(sprite, SpriteDiskCacheAlloc);
+	SaveSpriteToDiskCache(file, file_pos, sc->control_flags, s, _sprite_disk_cache_size);
+	return s;
 }
 
 struct GrfSpriteOffset {
@@ -665,10 +916,10 @@ bool LoadNextSprite(int load_index, SpriteFile &file, uint file_sprite_id)
 	}
 
 	SpriteCache *sc = AllocateSpriteCache(load_index);
+	if (sc->ptr != nullptr) DeleteEntryFromSpriteCache(load_index);
 	sc->file = &file;
 	sc->file_pos = file_pos;
 	sc->ptr = data;
-	sc->lru = 0;
 	sc->id = file_sprite_id;
 	sc->type = type;
 	sc->warned = false;
@@ -683,6 +934,7 @@ void DupSprite(SpriteID old_spr, SpriteID new_spr)
 	SpriteCache *scnew = AllocateSpriteCache(new_spr); // may reallocate: so put it first
 	SpriteCache *scold = GetSpriteCache(old_spr);
 
+	if (scnew->ptr != nullptr) DeleteEntryFromSpriteCache(new_spr);
 	scnew->file = scold->file;
 	scnew->file_pos = scold->file_pos;
 	scnew->ptr = nullptr;
@@ -691,197 +943,572 @@ void DupSprite(SpriteID old_spr, SpriteID new_spr)
 	scnew->warned = false;
 }
 
+static const uint32 INVALID_SLAB = UINT32_MAX;          ///< Slab of blocks that are allocated on their own.
+static const SpriteID INVALID_LRU_SPRITE = UINT32_MAX; ///< End marker of the LRU list of cached sprites.
+
+static const size_t SLAB_SIZE = 64 * 1024;           ///< Size of a single slab.
+static const uint MIN_SLAB_BLOCK_SIZE = 64;          ///< Block size of the smallest size class.
+static const uint MAX_SLAB_BLOCK_SIZE = 16 * 1024;   ///< Block size of the largest size class; larger blocks are allocated on their own.
+static const uint SIZE_CLASS_STEPS = 4;              ///< Number of size classes per doubling of the block size.
+static const uint SIZE_CLASS_COUNT = 8 * SIZE_CLASS_STEPS + 1; ///< Number of size classes, from #MIN_SLAB_BLOCK_SIZE to #MAX_SLAB_BLOCK_SIZE.
+static const uint EVICTION_SEARCH_DEPTH = 64;        ///< Number of least recently used sprites searched for one whose removal frees usable memory.
+
+/* Every size class must keep the blocks correctly aligned. */
+static_assert(MIN_SLAB_BLOCK_SIZE / SIZE_CLASS_STEPS % sizeof(MemBlock) == 0);
+
+/** A slab of memory, split into blocks of a single size class. */
+struct SpriteSlab {
+	byte *memory;     ///< Memory of the slab, or \c nullptr when this slab is not in use.
+	MemBlock *free;   ///< First free block of the slab; the next free block is stored in its data.
+	uint16 used;      ///< Number of blocks in use.
+	uint16 capacity;  ///< Number of blocks in the slab.
+	uint8 size_class; ///< Size class of the blocks.
+	uint32 prev;      ///< Previous slab of the size class with free blocks.
+	uint32 next;      ///< Next slab of the size class with free blocks.
+};
+
+static std::vector<SpriteSlab> _sprite_slabs;       ///< All slabs, including the unused ones.
+static std::vector<uint32> _unused_sprite_slabs;     ///< Indices of the unused entries in #_sprite_slabs.
+static uint32 _partial_sprite_slabs[SIZE_CLASS_COUNT]; ///< First slab with free blocks per size class.
+
+static SpriteID _sprite_lru_head = INVALID_LRU_SPRITE; ///< Most recently used cached sprite.
+static SpriteID _sprite_lru_tail = INVALID_LRU_SPRITE; ///< Least recently used cached sprite.
+
 /**
- * S_FREE_MASK is used to mask-out lower bits of MemBlock::size
- * If they are non-zero, the block is free.
- * S_FREE_MASK has to ensure MemBlock is correctly aligned -
- * it means 8B (S_FREE_MASK == 7) on 64bit systems!
+ * Get the size class for a block.
+ * The block sizes of the size classes grow in #SIZE_CLASS_STEPS steps per doubling,
+ * so at most a fifth of a block is wasted.
+ * @param size Size of the block, at most #MAX_SLAB_BLOCK_SIZE.
+ * @return The smallest size class the block fits in.
  */
-static const size_t S_FREE_MASK = sizeof(size_t) - 1;
+static uint GetSizeClass(size_t size)
+{
+	assert(size <= MAX_SLAB_BLOCK_SIZE);
+	if (size <= MIN_SLAB_BLOCK_SIZE) return 0;
 
-/* to make sure nobody adds things to MemBlock without checking S_FREE_MASK first */
-static_assert(sizeof(MemBlock) == sizeof(size_t));
-/* make sure it's a power of two */
-static_assert((sizeof(size_t) & (sizeof(size_t) - 1)) == 0);
+	/* Find the power of two range (2^bit, 2^(bit + 1)] and then the step within it. */
+	uint bit = FindLastBit(size - 1);
+	uint step = ((size - 1) >> (bit - 2)) & (SIZE_CLASS_STEPS - 1);
+	return (bit - FindLastBit(MIN_SLAB_BLOCK_SIZE)) * SIZE_CLASS_STEPS + step + 1;
+}
 
-static inline MemBlock *NextBlock(MemBlock *block)
+/**
+ * Get the block size of a size class.
+ * @param size_class The size class.
+ * @return The size of the blocks of the size class.
+ */
+static uint GetSizeClassBlockSize(uint size_class)
 {
-	return (MemBlock*)((byte*)block + (block->size & ~S_FREE_MASK));
+	if (size_class == 0) return MIN_SLAB_BLOCK_SIZE;
+
+	uint bit = (size_class - 1) / SIZE_CLASS_STEPS + FindLastBit(MIN_SLAB_BLOCK_SIZE);
+	uint step = (size_class - 1) % SIZE_CLASS_STEPS;
+	return (1U << bit) + ((step + 1) << (bit - 2));
 }
 
-static size_t GetSpriteCacheUsage()
+/**
+ * Add a slab to the list of slabs with free blocks of its size class.
+ * @param index The slab.
+ */
+static void LinkSpriteSlab(uint32 index)
 {
-	size_t tot_size = 0;
-	MemBlock *s;
+	SpriteSlab &slab = _sprite_slabs[index];
+	uint32 &head = _partial_sprite_slabs[slab.size_class];
+	slab.prev = INVALID_SLAB;
+	slab.next = head;
+	if (head != INVALID_SLAB) _sprite_slabs[head].prev = index;
+	head = index;
+}
 
-	for (s = _spritecache_ptr; s->size != 0; s = NextBlock(s)) {
-		if (!(s->size & S_FREE_MASK)) tot_size += s->size;
+/**
+ * Remove a slab from the list of slabs with free blocks of its size class.
+ * @param index The slab.
+ */
+static void UnlinkSpriteSlab(uint32 index)
+{
+	SpriteSlab &slab = _sprite_slabs[index];
+	if (slab.prev != INVALID_SLAB) {
+		_sprite_slabs[slab.prev].next = slab.next;
+	} else {
+		_partial_sprite_slabs[slab.size_class] = slab.next;
 	}
-
-	return tot_size;
+	if (slab.next != INVALID_SLAB) _sprite_slabs[slab.next].prev = slab.prev;
 }
 
-
-void IncreaseSpriteLRU()
+/**
+ * Lower the budget of the sprite cache to what it uses now, as the system has no more memory.
+ */
+static void LimitSpriteCacheBudget()
 {
-	/* Increase all LRU values */
-	if (_sprite_lru_counter > 16384) {
-		SpriteID i;
+	size_t budget = _allocated_sprite_cache_size;
+	_allocated_sprite_cache_size = _sprite_cache_allocated;
+	Debug(misc, 0, "Not enough memory to allocate {} MiB of spritecache. Spritecache was reduced to {} MiB.", budget / 1024 / 1024, _allocated_sprite_cache_size / 1024 / 1024);
+
+	ErrorMessageData msg(STR_CONFIG_ERROR_OUT_OF_MEMORY, STR_CONFIG_ERROR_SPRITECACHE_TOO_BIG);
+	msg.SetDParam(0, budget);
+	msg.SetDParam(1, _allocated_sprite_cache_size);
+	ScheduleErrorMessage(msg);
+}
 
-		Debug(sprite, 3, "Fixing lru {}, inuse={}", _sprite_lru_counter, GetSpriteCacheUsage());
+/**
+ * Get a new slab for a size class, and chain all its blocks into its free list.
+ * @param size_class The size class.
+ * @return The slab, or #INVALID_SLAB if there is no memory for it.
+ */
+static uint32 NewSpriteSlab(uint size_class)
+{
+	byte *memory;
+	try {
+		memory = new byte[SLAB_SIZE];
+	} catch (std::bad_alloc &) {
+		LimitSpriteCacheBudget();
+		return INVALID_SLAB;
+	}
 
-		for (i = 0; i != _spritecache_items; i++) {
-			SpriteCache *sc = GetSpriteCache(i);
-			if (sc->ptr != nullptr) {
-				if (sc->lru >= 0) {
-					sc->lru = -1;
-				} else if (sc->lru != -32768) {
-					sc->lru--;
-				}
-			}
-		}
-		_sprite_lru_counter = 0;
+	uint32 index;
+	if (_unused_sprite_slabs.empty()) {
+		index = (uint32)_sprite_slabs.size();
+		_sprite_slabs.emplace_back();
+	} else {
+		index = _unused_sprite_slabs.back();
+		_unused_sprite_slabs.pop_back();
 	}
 
-	/* Compact sprite cache every now and then. */
-	if (++_compact_cache_counter >= 740) {
-		CompactSpriteCache();
-		_compact_cache_counter = 0;
+	uint block_size = GetSizeClassBlockSize(size_class);
+	SpriteSlab &slab = _sprite_slabs[index];
+	slab.memory = memory;
+	slab.free = nullptr;
+	slab.used = 0;
+	slab.capacity = (uint16)(SLAB_SIZE / block_size);
+	slab.size_class = size_class;
+	for (uint i = slab.capacity; i-- > 0;) {
+		MemBlock *block = reinterpret_cast<MemBlock *>(slab.memory + i * block_size);
+		*reinterpret_cast<MemBlock **>(block->data) = slab.free;
+		slab.free = block;
 	}
+
+	LinkSpriteSlab(index);
+	_sprite_cache_allocated += SLAB_SIZE;
+	return index;
 }
 
 /**
- * Called when holes in the sprite cache should be removed.
- * That is accomplished by moving the cached data.
+ * Try to allocate a block without removing anything from the sprite cache.
+ * @param mem_req Size of the block, including its header.
+ * @return The block, or \c nullptr if there is not enough space.
  */
-static void CompactSpriteCache()
+static MemBlock *TryAllocSpriteBlock(size_t mem_req)
 {
-	MemBlock *s;
+	if (mem_req > MAX_SLAB_BLOCK_SIZE) {
+		if (_sprite_cache_allocated + mem_req > _allocated_sprite_cache_size) return nullptr;
 
-	Debug(sprite, 3, "Compacting sprite cache, inuse={}", GetSpriteCacheUsage());
+		MemBlock *block = reinterpret_cast<MemBlock *>(MallocT<byte>(mem_req));
+		block->slab = INVALID_SLAB;
+		_sprite_cache_allocated += mem_req;
+		return block;
+	}
 
-	for (s = _spritecache_ptr; s->size != 0;) {
-		if (s->size & S_FREE_MASK) {
-			MemBlock *next = NextBlock(s);
-			MemBlock temp;
-			SpriteID i;
+	uint size_class = GetSizeClass(mem_req);
+	uint32 index = _partial_sprite_slabs[size_class];
+	if (index == INVALID_SLAB) {
+		if (_sprite_cache_allocated + SLAB_SIZE > _allocated_sprite_cache_size) return nullptr;
+		index = NewSpriteSlab(size_class);
+		if (index == INVALID_SLAB) return nullptr;
+	}
 
-			/* Since free blocks are automatically coalesced, this should hold true. */
-			assert(!(next->size & S_FREE_MASK));
+	SpriteSlab &slab = _sprite_slabs[index];
+	MemBlock *block = slab.free;
+	slab.free = *reinterpret_cast<MemBlock **>(block->data);
+	if (++slab.used == slab.capacity) UnlinkSpriteSlab(index);
+	block->slab = index;
+	return block;
+}
 
-			/* If the next block is the sentinel block, we can safely return */
-			if (next->size == 0) break;
+/**
+ * Return a block to its slab, or free it when it was allocated on its own.
+ * Slabs that become empty are given back, so their memory can be used by any size class.
+ * @param block The block to free.
+ */
+static void FreeSpriteBlock(MemBlock *block)
+{
+	_sprite_cache_requested -= block->size;
 
-			/* Locate the sprite belonging to the next pointer. */
-			for (i = 0; GetSpriteCache(i)->ptr != next->data; i++) {
-				assert(i != _spritecache_items);
-			}
+	if (block->slab == INVALID_SLAB) {
+		_sprite_cache_allocated -= block->size;
+		free(block);
+		return;
+	}
 
-			GetSpriteCache(i)->ptr = s->data; // Adjust sprite array entry
-			/* Swap this and the next block */
-			temp = *s;
-			memmove(s, next, next->size);
-			s = NextBlock(s);
-			*s = temp;
+	uint32 index = block->slab;
+	SpriteSlab &slab = _sprite_slabs[index];
+	if (slab.used == slab.capacity) LinkSpriteSlab(index);
+	*reinterpret_cast<MemBlock **>(block->data) = slab.free;
+	slab.free = block;
+
+	if (--slab.used == 0) {
+		UnlinkSpriteSlab(index);
+		delete[] slab.memory;
+		slab.memory = nullptr;
+		_unused_sprite_slabs.push_back(index);
+		_sprite_cache_allocated -= SLAB_SIZE;
+	}
+}
 
-			/* Coalesce free blocks */
-			while (NextBlock(s)->size & S_FREE_MASK) {
-				s->size += NextBlock(s)->size & ~S_FREE_MASK;
-			}
-		} else {
-			s = NextBlock(s);
-		}
+/**
+ * Add a sprite at the front of the LRU list, as the most recently used one.
+ * @param item The sprite.
+ */
+static void LinkSpriteLRU(SpriteID item)
+{
+	SpriteCache *sc = GetSpriteCache(item);
+	sc->lru_prev = INVALID_LRU_SPRITE;
+	sc->lru_next = _sprite_lru_head;
+	if (_sprite_lru_head != INVALID_LRU_SPRITE) {
+		GetSpriteCache(_sprite_lru_head)->lru_prev = item;
+	} else {
+		_sprite_lru_tail = item;
+	}
+	_sprite_lru_head = item;
+}
+
+/**
+ * Remove a sprite from the LRU list.
+ * @param item The sprite.
+ */
+static void UnlinkSpriteLRU(SpriteID item)
+{
+	SpriteCache *sc = GetSpriteCache(item);
+	if (sc->lru_prev != INVALID_LRU_SPRITE) {
+		GetSpriteCache(sc->lru_prev)->lru_next = sc->lru_next;
+	} else {
+		_sprite_lru_head = sc->lru_next;
+	}
+	if (sc->lru_next != INVALID_LRU_SPRITE) {
+		GetSpriteCache(sc->lru_next)->lru_prev = sc->lru_prev;
+	} else {
+		_sprite_lru_tail = sc->lru_prev;
 	}
 }
 
 /**
  * Delete a single entry from the sprite cache.
+ * Recolour sprites are not part of the LRU list, as they are never removed to make space.
  * @param item Entry to delete.
  */
 static void DeleteEntryFromSpriteCache(uint item)
 {
-	/* Mark the block as free (the block must be in use) */
-	MemBlock *s = (MemBlock*)GetSpriteCache(item)->ptr - 1;
-	assert(!(s->size & S_FREE_MASK));
-	s->size |= S_FREE_MASK;
-	GetSpriteCache(item)->ptr = nullptr;
-
-	/* And coalesce adjacent free blocks */
-	for (s = _spritecache_ptr; s->size != 0; s = NextBlock(s)) {
-		if (s->size & S_FREE_MASK) {
-			while (NextBlock(s)->size & S_FREE_MASK) {
-				s->size += NextBlock(s)->size & ~S_FREE_MASK;
-			}
+	SpriteCache *sc = GetSpriteCache(item);
+	assert(sc->ptr != nullptr);
+
+	if (sc->type != ST_RECOLOUR) UnlinkSpriteLRU(item);
+	FreeSpriteBlock(reinterpret_cast<MemBlock *>(sc->ptr) - 1);
+	sc->ptr = nullptr;
+}
+
+/**
+ * Find the sprite to remove from the sprite cache to make space for a block.
+ * Removing a sprite of another size class only helps once its whole slab is
+ * empty, so among the least recently used sprites prefer one whose removal
+ * gives back memory that can be used right away: a block of the same size
+ * class, the last block of a slab, or a block allocated on its own.
+ * @param mem_req Size of the block, including its header.
+ * @return The sprite to remove.
+ */
+static SpriteID FindSpriteToEvict(size_t mem_req)
+{
+	if (mem_req > MAX_SLAB_BLOCK_SIZE) return _sprite_lru_tail;
+
+	uint size_class = GetSizeClass(mem_req);
+	SpriteID item = _sprite_lru_tail;
+	for (uint i = 0; i < EVICTION_SEARCH_DEPTH && item != INVALID_LRU_SPRITE; i++) {
+		const SpriteCache *sc = GetSpriteCache(item);
+		const MemBlock *block = reinterpret_cast<const MemBlock *>(sc->ptr) - 1;
+		if (block->slab == INVALID_SLAB) return item;
+
+		const SpriteSlab &slab = _sprite_slabs[block->slab];
+		if (slab.size_class == size_class || slab.used == 1) return item;
+		item = sc->lru_prev;
+	}
+	return _sprite_lru_tail;
+}
+
+static void *AllocSprite(size_t mem_req)
+{
+	mem_req += sizeof(MemBlock);
+
+	for (;;) {
+		MemBlock *block = TryAllocSpriteBlock(mem_req);
+		if (block != nullptr) {
+			block->size = (uint32)mem_req;
+			_sprite_cache_requested += mem_req;
+			return block->data;
 		}
+
+		/* Display an error message and die, in case there is nothing left to remove.
+		 * This shouldn't really happen, unless the sprite does not fit in the cache at all. */
+		if (_sprite_lru_tail == INVALID_LRU_SPRITE) error("Out of sprite memory");
+
+		SpriteID item = FindSpriteToEvict(mem_req);
+		Debug(sprite, 4, "Removing sprite {} from the sprite cache, inuse={}", item, _sprite_cache_requested);
+		DeleteEntryFromSpriteCache(item);
+		_sprite_cache_evictions++;
 	}
 }
 
-static void DeleteEntryFromSpriteCache()
+/**
+ * Get the statistics of the sprite cache.
+ * @return The statistics since the sprite cache was last initialised.
+ */
+SpriteCacheStatistics GetSpriteCacheStatistics()
 {
-	uint best = UINT_MAX;
-	int cur_lru;
+	SpriteCacheStatistics stats;
+	stats.budget = _allocated_sprite_cache_size;
+	stats.allocated = _sprite_cache_allocated;
+	stats.requested = _sprite_cache_requested;
+	stats.hits = _sprite_cache_hits;
+	stats.misses = _sprite_cache_misses;
+	stats.evictions = _sprite_cache_evictions;
+	return stats;
+}
 
-	Debug(sprite, 3, "DeleteEntryFromSpriteCache, inuse={}", GetSpriteCacheUsage());
+/**
+ * Sprite allocator simply using malloc.
+ */
+void *SimpleSpriteAlloc(size_t size)
+{
+	return MallocT<byte>(size);
+}
 
-	cur_lru = 0xffff;
-	for (SpriteID i = 0; i != _spritecache_items; i++) {
-		SpriteCache *sc = GetSpriteCache(i);
-		if (sc->type != ST_RECOLOUR && sc->ptr != nullptr && sc->lru < cur_lru) {
-			cur_lru = sc->lru;
-			best = i;
-		}
+/** Maximum number of sprites waiting to be prefetched, and of decoded sprites to remember. */
+static const size_t MAX_QUEUED_PREFETCH_SPRITES = 4096;
+
+/** A sprite that is decoded in the background, before it is drawn. */
+struct PrefetchedSprite {
+	SpriteCache entry;      ///< Copy of the cache entry, as the entries may be reallocated while decoding.
+	SpriteEncoder *encoder; ///< Encoder to use, which is the blitter at the moment the sprite was requested.
+	MemBlock *block;        ///< The decoded sprite, or \c nullptr while it is not decoded yet.
+	bool decoding;          ///< Whether a prefetch thread is decoding the sprite.
+	bool failed;            ///< Whether the sprite could not be loaded; the main thread substitutes the fallback sprite.
+};
+
+/**
+ * Threads decoding sprites that are likely to be drawn soon, and the sprites they decoded.
+ * The decoded sprites are kept outside of the sprite cache until they are actually drawn,
+ * so prefetching never pushes out sprites that are in use.
+ */
+static struct SpritePrefetcher {
+	std::mutex lock;                              ///< Protects all members.
+	std::condition_variable wake;                 ///< Signalled when sprites are queued or the threads have to stop.
+	std::condition_variable done;                 ///< Signalled when a sprite is decoded.
+	std::vector<std::thread> threads;             ///< The prefetch threads.
+	bool started = false;                         ///< Whether the threads have been started.
+	bool exit = false;                            ///< Whether the threads have to stop.
+	std::map<SpriteID, PrefetchedSprite> sprites; ///< Queued, decoding and decoded sprites.
+	std::deque<SpriteID> queue;                   ///< Sprites waiting to be decoded, oldest first.
+	std::deque<SpriteID> decoded;                 ///< Decoded sprites, oldest first.
+	size_t decoded_size = 0;                      ///< Memory used by the decoded sprites.
+
+	~SpritePrefetcher()
+	{
+		/* The threads are stopped by StopSpritePrefetchThreads; only when exiting
+		 * without shutting down the game they are still running, and then they are
+		 * left alone, as joining or destroying them would terminate. */
+		for (std::thread &t : this->threads) t.detach();
 	}
+} _sprite_prefetcher;
 
-	/* Display an error message and die, in case we found no sprite at all.
-	 * This shouldn't really happen, unless all sprites are locked. */
-	if (best == UINT_MAX) error("Out of sprite memory");
+static bool _sprite_prefetch_only = false; ///< Whether sprites that are not cached are only queued for prefetching.
 
-	DeleteEntryFromSpriteCache(best);
+/**
+ * Allocator for prefetched sprites; it allocates a block on its own so
+ * the size is known when the sprite is moved into the sprite cache.
+ * @param size Size of the sprite.
+ * @return Memory for the sprite.
+ */
+static void *PrefetchSpriteAlloc(size_t size)
+{
+	MemBlock *block = reinterpret_cast<MemBlock *>(MallocT<byte>(sizeof(MemBlock) + size));
+	block->size = (uint32)(sizeof(MemBlock) + size);
+	block->slab = INVALID_SLAB;
+	return block->data;
 }
 
-static void *AllocSprite(size_t mem_req)
+/** Main loop of a prefetch thread. */
+static void SpritePrefetchThread()
 {
-	mem_req += sizeof(MemBlock);
+	std::unique_lock<std::mutex> lock(_sprite_prefetcher.lock);
+	for (;;) {
+		_sprite_prefetcher.wake.wait(lock, [] { return _sprite_prefetcher.exit || !_sprite_prefetcher.queue.empty(); });
+		if (_sprite_prefetcher.exit) return;
+
+		SpriteID sprite = _sprite_prefetcher.queue.front();
+		_sprite_prefetcher.queue.pop_front();
+
+		/* The sprite has been loaded or cancelled meanwhile. */
+		auto it = _sprite_prefetcher.sprites.find(sprite);
+		if (it == _sprite_prefetcher.sprites.end() || it->second.block != nullptr || it->second.decoding) continue;
+
+		it->second.decoding = true;
+		SpriteCache entry = it->second.entry;
+		SpriteEncoder *encoder = it->second.encoder;
+		lock.unlock();
+
+		void *data = ReadSprite(&entry, sprite, entry.type, PrefetchSpriteAlloc, encoder);
+
+		lock.lock();
+		/* Map entries are never removed while decoding, so the iterator is still valid. */
+		it->second.decoding = false;
+		if (data == nullptr) {
+			/* The fallback sprite comes from the sprite cache, which only the main thread may use. */
+			it->second.failed = true;
+			_sprite_prefetcher.done.notify_all();
+			continue;
+		}
+		it->second.block = reinterpret_cast<MemBlock *>(data) - 1;
+		_sprite_prefetcher.decoded.push_back(sprite);
+		_sprite_prefetcher.decoded_size += it->second.block->size;
+
+		/* Drop the oldest sprites that were never drawn, as they will likely not be needed anymore. */
+		while (_sprite_prefetcher.decoded_size > _allocated_sprite_cache_size / 4 || _sprite_prefetcher.decoded.size() > MAX_QUEUED_PREFETCH_SPRITES) {
+			auto old = _sprite_prefetcher.sprites.find(_sprite_prefetcher.decoded.front());
+			_sprite_prefetcher.decoded.pop_front();
+			if (old == _sprite_prefetcher.sprites.end() || old->second.block == nullptr) continue;
+
+			_sprite_prefetcher.decoded_size -= old->second.block->size;
+			free(old->second.block);
+			_sprite_prefetcher.sprites.erase(old);
+		}
 
-	/* Align this to correct boundary. This also makes sure at least one
-	 * bit is not used, so we can use it for other things. */
-	mem_req = Align(mem_req, S_FREE_MASK + 1);
+		_sprite_prefetcher.done.notify_all();
+	}
+}
 
-	for (;;) {
-		MemBlock *s;
-
-		for (s = _spritecache_ptr; s->size != 0; s = NextBlock(s)) {
-			if (s->size & S_FREE_MASK) {
-				size_t cur_size = s->size & ~S_FREE_MASK;
-
-				/* Is the block exactly the size we need or
-				 * big enough for an additional free block? */
-				if (cur_size == mem_req ||
-						cur_size >= mem_req + sizeof(MemBlock)) {
-					/* Set size and in use */
-					s->size = mem_req;
-
-					/* Do we need to inject a free block too? */
-					if (cur_size != mem_req) {
-						NextBlock(s)->size = (cur_size - mem_req) | S_FREE_MASK;
-					}
+/**
+ * Queue a sprite for decoding by the prefetch threads.
+ * @param sprite The sprite.
+ * @param sc Cache entry of the sprite.
+ */
+static void QueueSpritePrefetch(SpriteID sprite, const SpriteCache *sc)
+{
+	std::lock_guard<std::mutex> guard(_sprite_prefetcher.lock);
+	if (_sprite_prefetcher.queue.size() >= MAX_QUEUED_PREFETCH_SPRITES) return;
 
-					return s->data;
-				}
+	auto res = _sprite_prefetcher.sprites.emplace(sprite, PrefetchedSprite{ *sc, BlitterFactory::GetCurrentBlitter(), nullptr, false, false });
+	if (!res.second) return;
+
+	_sprite_prefetcher.queue.push_back(sprite);
+	_sprite_prefetcher.wake.notify_one();
+}
+
+/**
+ * Get a sprite from the prefetch threads and put it into the sprite cache.
+ * When the sprite is being decoded, wait for it; when it is only queued, take it out of the queue.
+ * @param sprite The sprite.
+ * @return The sprite in the sprite cache, the fallback sprite if it could not be loaded, or \c nullptr if it has not been decoded.
+ */
+static void *TakePrefetchedSprite(SpriteID sprite)
+{
+	MemBlock *block;
+	bool failed;
+	{
+		std::unique_lock<std::mutex> lock(_sprite_prefetcher.lock);
+		auto it = _sprite_prefetcher.sprites.find(sprite);
+		if (it == _sprite_prefetcher.sprites.end()) return nullptr;
+
+		_sprite_prefetcher.done.wait(lock, [&it] { return !it->second.decoding; });
+
+		block = it->second.block;
+		failed = it->second.failed;
+		if (block != nullptr) _sprite_prefetcher.decoded_size -= block->size;
+		_sprite_prefetcher.sprites.erase(it);
+	}
+	if (failed) return GetRawSprite(SPR_IMG_QUERY, ST_NORMAL, AllocSprite);
+	if (block == nullptr) return nullptr;
+
+	size_t size = block->size - sizeof(MemBlock);
+	void *ptr = AllocSprite(size);
+	memcpy(ptr, block->data, size);
+	free(block);
+	return ptr;
+}
+
+/**
+ * Stop prefetching: forget the queued sprites, wait for the ones being decoded and
+ * throw away all decoded sprites. Needed before the sprites, their files or the
+ * blitter change.
+ */
+void CancelSpritePrefetch()
+{
+	std::unique_lock<std::mutex> lock(_sprite_prefetcher.lock);
+	_sprite_prefetcher.queue.clear();
+	_sprite_prefetcher.done.wait(lock, [] {
+		return std::none_of(_sprite_prefetcher.sprites.begin(), _sprite_prefetcher.sprites.end(), [](const auto &it) { return it.second.decoding; });
+	});
+
+	for (auto &it : _sprite_prefetcher.sprites) free(it.second.block);
+	_sprite_prefetcher.sprites.clear();
+	_sprite_prefetcher.decoded.clear();
+	_sprite_prefetcher.decoded_size = 0;
+}
+
+/**
+ * Start collecting sprites for prefetching. Until #EndSpritePrefetch, sprites
+ * that are not in the sprite cache are queued for decoding in the background,
+ * and a placeholder is returned instead, so only their IDs should be used.
+ * @return False when there are no threads for prefetching; nothing has been started then.
+ */
+bool BeginSpritePrefetch()
+{
+	{
+		std::lock_guard<std::mutex> guard(_sprite_prefetcher.lock);
+		if (!_sprite_prefetcher.started) {
+			_sprite_prefetcher.started = true;
+
+			/* Leave the other cores to drawing and the link graph. */
+			uint threads = std::min(2U, std::max(std::thread::hardware_concurrency(), 1U) - 1);
+			for (uint i = 0; i < threads; i++) {
+				std::thread t;
+				if (!StartNewThread(&t, "ottd:sprites", &SpritePrefetchThread)) break;
+				_sprite_prefetcher.threads.push_back(std::move(t));
 			}
+			Debug(sprite, 1, "Started {} sprite prefetch threads", _sprite_prefetcher.threads.size());
 		}
-
-		/* Reached sentinel, but no block found yet. Delete some old entry. */
-		DeleteEntryFromSpriteCache();
+		if (_sprite_prefetcher.threads.empty()) return false;
 	}
+
+	_sprite_prefetch_only = true;
+	return true;
+}
+
+/** Stop collecting sprites for prefetching. */
+void EndSpritePrefetch()
+{
+	_sprite_prefetch_only = false;
 }
 
 /**
- * Sprite allocator simply using malloc.
+ * Whether sprites are being collected for prefetching.
+ * @return True between #BeginSpritePrefetch and #EndSpritePrefetch.
  */
-void *SimpleSpriteAlloc(size_t size)
+bool IsSpritePrefetching()
 {
-	return MallocT<byte>(size);
+	return _sprite_prefetch_only;
+}
+
+/**
+ * Stop the prefetch threads and throw away everything they decoded.
+ * Prefetching is not started again afterwards; this is part of shutting down the game.
+ */
+void StopSpritePrefetchThreads()
+{
+	CancelSpritePrefetch();
+	{
+		std::lock_guard<std::mutex> guard(_sprite_prefetcher.lock);
+		_sprite_prefetcher.exit = true;
+	}
+	_sprite_prefetcher.wake.notify_all();
+	for (std::thread &t : _sprite_prefetcher.threads) t.join();
+	_sprite_prefetcher.threads.clear();
 }
 
 /**
@@ -957,16 +1584,35 @@ void *GetRawSprite(SpriteID sprite, SpriteType type, AllocatorProc *allocator, S
 	if (allocator == nullptr && encoder == nullptr) {
 		/* Load sprite into/from spritecache */
 
-		/* Update LRU */
-		sc->lru = ++_sprite_lru_counter;
+		if (sc->ptr == nullptr) {
+			if (_sprite_prefetch_only && type == ST_NORMAL && sprite != SPR_IMG_QUERY) {
+				QueueSpritePrefetch(sprite, sc);
+				return GetRawSprite(SPR_IMG_QUERY, ST_NORMAL);
+			}
 
-		/* Load the sprite, if it is not loaded, yet */
-		if (sc->ptr == nullptr) sc->ptr = ReadSprite(sc, sprite, type, AllocSprite, nullptr);
+			/* Load the sprite, as it is not loaded yet; it might already be decoded in the background. */
+			_sprite_cache_misses++;
+			sc->ptr = TakePrefetchedSprite(sprite);
+			if (sc->ptr == nullptr) sc->ptr = ReadSprite(sc, sprite, type, AllocSprite, nullptr);
+			if (sc->ptr == nullptr && type != ST_MAPGEN) sc->ptr = GetRawSprite(SPR_IMG_QUERY, ST_NORMAL, AllocSprite);
+			if (sc->ptr != nullptr && type != ST_RECOLOUR) LinkSpriteLRU(sprite);
+		} else if (type != ST_RECOLOUR) {
+			/* Recolour sprites stay cached and are not counted as hits. */
+			if (!_sprite_prefetch_only) _sprite_cache_hits++;
+
+			/* Update LRU */
+			if (_sprite_lru_head != sprite) {
+				UnlinkSpriteLRU(sprite);
+				LinkSpriteLRU(sprite);
+			}
+		}
 
 		return sc->ptr;
 	} else {
 		/* Do not use the spritecache, but a different allocator. */
-		return ReadSprite(sc, sprite, type, allocator, encoder);
+		void *data = ReadSprite(sc, sprite, type, allocator, encoder);
+		if (data == nullptr && type != ST_MAPGEN) data = GetRawSprite(SPR_IMG_QUERY, ST_NORMAL, allocator, encoder);
+		return data;
 	}
 }
 
@@ -975,55 +1621,37 @@ static void GfxInitSpriteCache()
 {
 	/* initialize sprite cache heap */
 	int bpp = BlitterFactory::GetCurrentBlitter()->GetScreenDepth();
-	uint target_size = (bpp > 0 ? _sprite_cache_size * bpp / 8 : 1) * 1024 * 1024;
-
-	/* Remember 'target_size' from the previous allocation attempt, so we do not try to reach the target_size multiple times in case of failure. */
-	static uint last_alloc_attempt = 0;
+	size_t target_size = (bpp > 0 ? _sprite_cache_size * bpp / 8 : 1) * 1024 * 1024;
 
-	if (_spritecache_ptr == nullptr || (_allocated_sprite_cache_size != target_size && target_size != last_alloc_attempt)) {
-		delete[] reinterpret_cast<byte *>(_spritecache_ptr);
+	/* Remember 'target_size' from the previous attempt, so we do not try to reach it again after running out of memory.
+	 * The slabs are allocated when needed; when that fails the budget is lowered to what could be allocated. */
+	static size_t last_alloc_attempt = 0;
 
+	if (target_size != last_alloc_attempt) {
 		last_alloc_attempt = target_size;
 		_allocated_sprite_cache_size = target_size;
+	}
 
-		do {
-			try {
-				/* Try to allocate 50% more to make sure we do not allocate almost all available. */
-				_spritecache_ptr = reinterpret_cast<MemBlock *>(new byte[_allocated_sprite_cache_size + _allocated_sprite_cache_size / 2]);
-			} catch (std::bad_alloc &) {
-				_spritecache_ptr = nullptr;
-			}
-
-			if (_spritecache_ptr != nullptr) {
-				/* Allocation succeeded, but we wanted less. */
-				delete[] reinterpret_cast<byte *>(_spritecache_ptr);
-				_spritecache_ptr = reinterpret_cast<MemBlock *>(new byte[_allocated_sprite_cache_size]);
-			} else if (_allocated_sprite_cache_size < 2 * 1024 * 1024) {
-				usererror("Cannot allocate spritecache");
-			} else {
-				/* Try again to allocate half. */
-				_allocated_sprite_cache_size >>= 1;
-			}
-		} while (_spritecache_ptr == nullptr);
-
-		if (_allocated_sprite_cache_size != target_size) {
-			Debug(misc, 0, "Not enough memory to allocate {} MiB of spritecache. Spritecache was reduced to {} MiB.", target_size / 1024 / 1024, _allocated_sprite_cache_size / 1024 / 1024);
-
-			ErrorMessageData msg(STR_CONFIG_ERROR_OUT_OF_MEMORY, STR_CONFIG_ERROR_SPRITECACHE_TOO_BIG);
-			msg.SetDParam(0, target_size);
-			msg.SetDParam(1, _allocated_sprite_cache_size);
-			ScheduleErrorMessage(msg);
-		}
+	/* Release everything that is still cached; this gives back all slabs. */
+	for (uint i = 0; i != _spritecache_items; i++) {
+		if (GetSpriteCache(i)->ptr != nullptr) DeleteEntryFromSpriteCache(i);
 	}
+	assert(_sprite_cache_allocated == 0);
+	assert(_sprite_lru_head == INVALID_LRU_SPRITE);
+
+	_sprite_slabs.clear();
+	_unused_sprite_slabs.clear();
+	std::fill(std::begin(_partial_sprite_slabs), std::end(_partial_sprite_slabs), INVALID_SLAB);
 
-	/* A big free block */
-	_spritecache_ptr->size = (_allocated_sprite_cache_size - sizeof(MemBlock)) | S_FREE_MASK;
-	/* Sentinel block (identified by size == 0) */
-	NextBlock(_spritecache_ptr)->size = 0;
+	_sprite_cache_hits = 0;
+	_sprite_cache_misses = 0;
+	_sprite_cache_evictions = 0;
 }
 
 void GfxInitSpriteMem()
 {
+	CancelSpritePrefetch();
+	CloseSpriteDiskCaches();
 	GfxInitSpriteCache();
 
 	/* Reset the spritecache 'pool' */
@@ -1031,7 +1659,6 @@ void GfxInitSpriteMem()
 	_spritecache_items = 0;
 	_spritecache = nullptr;
 
-	_compact_cache_counter = 0;
 	_sprite_files.clear();
 }
 
@@ -1041,13 +1668,13 @@ void GfxInitSpriteMem()
  */
 void GfxClearSpriteCache()
 {
-	/* Clear sprite ptr for all cached items */
-	for (uint i = 0; i != _spritecache_items; i++) {
-		SpriteCache *sc = GetSpriteCache(i);
-		if (sc->type != ST_RECOLOUR && sc->ptr != nullptr) DeleteEntryFromSpriteCache(i);
-	}
+	CancelSpritePrefetch();
+	CloseSpriteDiskCaches();
+
+	/* Clear sprite ptr for all cached items, which are exactly the ones in the LRU list */
+	while (_sprite_lru_tail != INVALID_LRU_SPRITE) DeleteEntryFromSpriteCache(_sprite_lru_tail);
 
 	VideoDriver::GetInstance()->ClearSystemSprites();
 }
 
-/* static */ ReusableBuffer<SpriteLoader::CommonPixel> SpriteLoader::Sprite::buffer[ZOOM_LVL_COUNT];
+/* static */ thread_local ReusableBuffer<SpriteLoader::CommonPixel> SpriteLoader::Sprite::buffer[ZOOM_LVL_COUNT];
@@ -30,6 +30,7 @@ enum SpriteCacheCtrlFlags {
 };
 
 extern uint _sprite_cache_size;
+extern bool _sprite_disk_cache;
 
 typedef void *AllocatorProc(size_t size);
 
@@ -58,7 +59,24 @@ static inline const byte *GetNonSprite(SpriteID sprite, SpriteType type)
 
 void GfxInitSpriteMem();
 void GfxClearSpriteCache();
-void IncreaseSpriteLRU();
+
+/** Statistics of the sprite cache, for the frame rate window. */
+struct SpriteCacheStatistics {
+	size_t budget;    ///< Maximum amount of memory the sprite cache may use.
+	size_t allocated; ///< Memory held by the sprite cache, including unused slab blocks.
+	size_t requested; ///< Memory requested for the cached sprites.
+	uint64 hits;      ///< Number of sprite requests served from the cache.
+	uint64 misses;    ///< Number of sprite requests that needed the sprite to be loaded.
+	uint64 evictions; ///< Number of sprites removed from the cache to make space.
+};
+
+SpriteCacheStatistics GetSpriteCacheStatistics();
+
+bool BeginSpritePrefetch();
+void EndSpritePrefetch();
+bool IsSpritePrefetching();
+void CancelSpritePrefetch();
+void StopSpritePrefetchThreads();
 
 SpriteFile &OpenCachedSpriteFile(const std::string &filename, Subdirectory subdir, bool palette_remap);
 
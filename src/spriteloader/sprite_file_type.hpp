@@ -20,6 +20,8 @@ class SpriteFile : public RandomAccessFile {
 	bool palette_remap;     ///< Whether or not a remap of the palette is required for this file.
 	byte container_version; ///< Container format of the sprite file.
 	size_t content_begin;   ///< The begin of the content of the sprite file, i.e. after the container metadata.
+	bool has_md5sum;        ///< Whether the MD5 checksum of the file is known.
+	uint8 md5sum[16];       ///< MD5 checksum of the file, if known.
 public:
 	SpriteFile(const std::string &filename, Subdirectory subdir, bool palette_remap);
 	SpriteFile(const SpriteFile&) = delete;
@@ -41,6 +43,22 @@ public:
 	 * Seek to the begin of the content, i.e. the position just after the container version has been determined.
 	 */
 	void SeekToBegin() { this->SeekTo(this->content_begin, SEEK_SET); }
+
+	/**
+	 * Set the MD5 checksum of the file, which identifies its content for the sprite disk cache.
+	 * @param md5sum The checksum.
+	 */
+	void SetMD5Sum(const uint8 md5sum[16])
+	{
+		memcpy(this->md5sum, md5sum, sizeof(this->md5sum));
+		this->has_md5sum = true;
+	}
+
+	/**
+	 * Get the MD5 checksum of the file.
+	 * @return The checksum, or \c nullptr when it is not known.
+	 */
+	const uint8 *GetMD5Sum() const { return this->has_md5sum ? this->md5sum : nullptr; }
 };
 
 #endif /* SPRITE_FILE_TYPE_HPP */
@@ -20,6 +20,7 @@
 #include "vehiclelist.h"
 #include "core/pool_func.hpp"
 #include "station_base.h"
+#include "station_func.h"
 #include "station_kdtree.h"
 #include "roadstop_base.h"
 #include "industry.h"
@@ -63,6 +64,34 @@ BaseStation::~BaseStation()
 	this->sign.MarkDirty();
 }
 
+/** Number of bits of the tile coordinates that select a tile within a cell of the catchment index. */
+static const uint CATCHMENT_INDEX_CELL_BITS = 4;
+
+/** For each square cell of the map, the stations whose catchment area covers a tile in it, sorted on their index. */
+static std::vector<std::vector<StationID>> _catchment_index;
+static uint _catchment_index_size_x; ///< Number of cells of the catchment index along the X axis.
+static uint _catchment_index_size_y; ///< Number of cells of the catchment index along the Y axis.
+
+/**
+ * Remove all stations from the catchment index, e.g.\ when all stations are removed at once.
+ */
+static void ClearCatchmentIndex()
+{
+	_catchment_index.clear();
+	_catchment_index_size_x = 0;
+	_catchment_index_size_y = 0;
+}
+
+/**
+ * Get the cell of the catchment index a tile belongs to.
+ * @param tile The tile.
+ * @return Index of the cell in #_catchment_index.
+ */
+static inline uint GetCatchmentIndexCell(TileIndex tile)
+{
+	return (TileY(tile) >> CATCHMENT_INDEX_CELL_BITS) * _catchment_index_size_x + (TileX(tile) >> CATCHMENT_INDEX_CELL_BITS);
+}
+
 Station::Station(TileIndex tile) :
 	SpecializedStation<Station, false>(tile),
 	bus_station(INVALID_TILE, 0, 0),
@@ -89,6 +118,7 @@ Station::~Station()
 		for (CargoID c = 0; c < NUM_CARGO; c++) {
 			this->goods[c].cargo.OnCleanPool();
 		}
+		ClearCatchmentIndex();
 		return;
 	}
 
@@ -108,7 +138,7 @@ Station::~Station()
 		for (NodeID node = 0; node < lg->Size(); ++node) {
 			Station *st = Station::Get((*lg)[node].Station());
 			st->goods[c].flows.erase(this->index);
-			if ((*lg)[node][this->goods[c].node].LastUpdate() != INVALID_DATE) {
+			if ((*lg)[node].HasEdgeTo(this->goods[c].node) && (*lg)[node][this->goods[c].node].LastUpdate() != INVALID_DATE) {
 				st->goods[c].flows.DeleteFlows(this->index);
 				RerouteCargo(st, c, this->index, st->index);
 			}
@@ -132,6 +162,7 @@ Station::~Station()
 
 	/* Remove station from industries and towns that reference it. */
 	this->RemoveFromAllNearbyLists();
+	this->RemoveFromCatchmentIndex();
 
 	/* Clear the persistent storage. */
 	delete this->airport.psa;
@@ -204,7 +235,9 @@ void Station::AddFacility(StationFacility new_facility_bit, TileIndex facil_xy)
 		this->MoveSign(facil_xy);
 		this->random_bits = Random();
 	}
+	bool was_in_use = this->IsInUse();
 	this->facilities |= new_facility_bit;
+	if (!was_in_use) ScheduleStationRating(this);
 	this->owner = _current_company;
 	this->build_date = _date;
 }
@@ -408,6 +441,83 @@ void Station::RemoveFromAllNearbyLists()
 	for (Industry *i : Industry::Iterate()) { i->stations_near.erase(this); }
 }
 
+/**
+ * List this station in the cells of the catchment index that its catchment area covers.
+ */
+void Station::AddToCatchmentIndex()
+{
+	uint size_x = (tile_map.size_x + (1 << CATCHMENT_INDEX_CELL_BITS) - 1) >> CATCHMENT_INDEX_CELL_BITS;
+	uint size_y = (tile_map.size_y + (1 << CATCHMENT_INDEX_CELL_BITS) - 1) >> CATCHMENT_INDEX_CELL_BITS;
+	if (size_x != _catchment_index_size_x || size_y != _catchment_index_size_y) {
+		/* Anything still in the index was on a previous map. */
+		ClearCatchmentIndex();
+		_catchment_index.resize(size_x * size_y);
+		_catchment_index_size_x = size_x;
+		_catchment_index_size_y = size_y;
+	}
+
+	assert(this->catchment_cells.empty());
+	BitmapTileIterator it(this->catchment_tiles);
+	for (TileIndex tile = it; tile != INVALID_TILE; tile = ++it) {
+		uint cell = GetCatchmentIndexCell(tile);
+		if (this->catchment_cells.empty() || this->catchment_cells.back() != cell) this->catchment_cells.push_back(cell);
+	}
+	std::sort(this->catchment_cells.begin(), this->catchment_cells.end());
+	this->catchment_cells.erase(std::unique(this->catchment_cells.begin(), this->catchment_cells.end()), this->catchment_cells.end());
+
+	for (uint cell : this->catchment_cells) {
+		std::vector<StationID> &stations = _catchment_index[cell];
+		auto pos = std::lower_bound(stations.begin(), stations.end(), this->index);
+		if (pos == stations.end() || *pos != this->index) stations.insert(pos, this->index);
+	}
+}
+
+/**
+ * Remove this station from the cells of the catchment index it is listed in.
+ */
+void Station::RemoveFromCatchmentIndex()
+{
+	for (uint cell : this->catchment_cells) {
+		if (cell >= _catchment_index.size()) break;
+
+		std::vector<StationID> &stations = _catchment_index[cell];
+		auto pos = std::lower_bound(stations.begin(), stations.end(), this->index);
+		if (pos != stations.end() && *pos == this->index) stations.erase(pos);
+	}
+	this->catchment_cells.clear();
+}
+
+/**
+ * Find the stations whose catchment area might cover a tile of the given area.
+ * All stations that do are found, but also some whose catchment area is only near the area.
+ * @param ta The area.
+ * @param[out] stations The stations, sorted on their index.
+ */
+void FindStationsInCatchmentIndex(const TileArea &ta, std::vector<StationID> &stations)
+{
+	if (ta.w == 0 || ta.h == 0) return;
+
+	uint x1 = TileX(ta.tile) >> CATCHMENT_INDEX_CELL_BITS;
+	uint y1 = TileY(ta.tile) >> CATCHMENT_INDEX_CELL_BITS;
+	uint x2 = (TileX(ta.tile) + ta.w - 1) >> CATCHMENT_INDEX_CELL_BITS;
+	uint y2 = (TileY(ta.tile) + ta.h - 1) >> CATCHMENT_INDEX_CELL_BITS;
+
+	/* The index is only sized for the map when the first station is added to it. */
+	if (x2 >= _catchment_index_size_x || y2 >= _catchment_index_size_y) return;
+
+	for (uint y = y1; y <= y2; y++) {
+		for (uint x = x1; x <= x2; x++) {
+			const std::vector<StationID> &cell = _catchment_index[y * _catchment_index_size_x + x];
+			stations.insert(stations.end(), cell.begin(), cell.end());
+		}
+	}
+
+	if (x1 != x2 || y1 != y2) {
+		std::sort(stations.begin(), stations.end());
+		stations.erase(std::unique(stations.begin(), stations.end()), stations.end());
+	}
+}
+
 /**
  * Test if the given town ID is covered by our catchment area.
  * This is used when removing a house tile to determine if it was the last house tile
@@ -432,6 +542,8 @@ void Station::RecomputeCatchment()
 {
 	this->industries_near.clear();
 	this->RemoveFromAllNearbyLists();
+	this->RemoveFromCatchmentIndex();
+	this->cached_acceptance_valid = false;
 
 	if (this->rect.IsEmpty()) {
 		this->catchment_tiles.Reset();
@@ -453,6 +565,7 @@ void Station::RecomputeCatchment()
 		this->industry->stations_near.clear();
 		this->industry->stations_near.insert(this);
 		this->industries_near.insert(IndustryListEntry{0, this->industry});
+		this->AddToCatchmentIndex();
 		return;
 	}
 
@@ -471,6 +584,8 @@ void Station::RecomputeCatchment()
 		for (TileIndex tile2 : ta2) this->catchment_tiles.SetTile(tile2);
 	}
 
+	this->AddToCatchmentIndex();
+
 	/* Search catchment tiles for towns and industries */
 	BitmapTileIterator it(this->catchment_tiles);
 	for (TileIndex tile = it; tile != INVALID_TILE; tile = ++it) {
@@ -18,6 +18,7 @@
 #include "linkgraph/linkgraph_type.h"
 #include "newgrf_storage.h"
 #include "bitmap_type.h"
+#include <list>
 #include <map>
 #include <set>
 
@@ -32,7 +33,11 @@ static const byte INITIAL_STATION_RATING = 175;
  */
 class FlowStat {
 public:
-	typedef std::map<uint32, StationID> SharesMap;
+	/**
+	 * Flat list of shares, sorted by the cumulative amount of flow up to and
+	 * including each share. Lookups are binary searches on a contiguous array.
+	 */
+	typedef std::vector<std::pair<uint32, StationID> > SharesMap;
 
 	static const SharesMap empty_sharesmap;
 
@@ -52,7 +57,7 @@ public:
 	inline FlowStat(StationID st, uint flow, bool restricted = false)
 	{
 		assert(flow > 0);
-		this->shares[flow] = st;
+		this->shares.emplace_back(flow, st);
 		this->unrestricted = restricted ? 0 : flow;
 	}
 
@@ -67,7 +72,7 @@ public:
 	inline void AppendShare(StationID st, uint flow, bool restricted = false)
 	{
 		assert(flow > 0);
-		this->shares[(--this->shares.end())->first + flow] = st;
+		this->shares.emplace_back(this->shares.back().first + flow, st);
 		if (!restricted) this->unrestricted += flow;
 	}
 
@@ -108,7 +113,7 @@ public:
 	/**
 	 * Get a station a package can be routed to. This done by drawing a
 	 * random number between 0 and sum_shares and then looking that up in
-	 * the map with lower_bound. So each share gets selected with a
+	 * the shares with a binary search. So each share gets selected with a
 	 * probability dependent on its flow. Do include restricted flows here.
 	 * @param is_restricted Output if a restricted flow was chosen.
 	 * @return A station ID from the shares map.
@@ -116,15 +121,15 @@ public:
 	inline StationID GetViaWithRestricted(bool &is_restricted) const
 	{
 		assert(!this->shares.empty());
-		uint rand = RandomRange((--this->shares.end())->first);
+		uint rand = RandomRange(this->shares.back().first);
 		is_restricted = rand >= this->unrestricted;
-		return this->shares.upper_bound(rand)->second;
+		return this->UpperBound(rand)->second;
 	}
 
 	/**
 	 * Get a station a package can be routed to. This done by drawing a
 	 * random number between 0 and sum_shares and then looking that up in
-	 * the map with lower_bound. So each share gets selected with a
+	 * the shares with a binary search. So each share gets selected with a
 	 * probability dependent on its flow. Don't include restricted flows.
 	 * @return A station ID from the shares map.
 	 */
@@ -132,7 +137,7 @@ public:
 	{
 		assert(!this->shares.empty());
 		return this->unrestricted > 0 ?
-				this->shares.upper_bound(RandomRange(this->unrestricted))->second :
+				this->UpperBound(RandomRange(this->unrestricted))->second :
 				INVALID_STATION;
 	}
 
@@ -143,6 +148,17 @@ public:
 private:
 	SharesMap shares;  ///< Shares of flow to be sent via specified station (or consumed locally).
 	uint unrestricted; ///< Limit for unrestricted shares.
+
+	/**
+	 * Find the first share with a cumulative flow greater than the given one.
+	 * @param flow Cumulative flow to look for.
+	 * @return Iterator to the share containing flow, or end() if there is none.
+	 */
+	inline SharesMap::const_iterator UpperBound(uint32 flow) const
+	{
+		return std::upper_bound(this->shares.begin(), this->shares.end(), flow,
+				[](uint32 flow, const SharesMap::value_type &share) { return flow < share.first; });
+	}
 };
 
 /** Flow descriptions by origin stations. */
@@ -472,6 +488,7 @@ public:
 	IndustryType indtype;   ///< Industry type to get the name from
 
 	BitmapTileArea catchment_tiles; ///< NOSAVE: Set of individual tiles covered by catchment area
+	std::vector<uint> catchment_cells; ///< NOSAVE: Cells of the catchment index this station is listed in, see FindStationsInCatchmentIndex()
 
 	StationHadVehicleOfType had_vehicle_of_type;
 
@@ -480,8 +497,11 @@ public:
 
 	byte last_vehicle_type;
 	std::list<Vehicle *> loading_vehicles;
+	uint64 next_rating_update;    ///< NOSAVE: Value of the station tick clock at which the ratings are updated next, see ScheduleStationRating().
 	GoodsEntry goods[NUM_CARGO];  ///< Goods at this station
 	CargoTypes always_accepted;       ///< Bitmask of always accepted cargo types (by houses, HQs, industry tiles when industry doesn't accept cargo)
+	CargoArray cached_acceptance;     ///< NOSAVE: Acceptance around the station at the last full computation, see UpdateStationAcceptance()
+	bool cached_acceptance_valid;     ///< NOSAVE: Whether #cached_acceptance still holds, see InvalidateStationAcceptance()
 
 	IndustryList industries_near; ///< Cached list of industries near the station that can accept cargo, @see DeliverGoodsToIndustry()
 	Industry *industry;           ///< NOSAVE: Associated industry for neutral stations. (Rebuilt on load from Industry->st)
@@ -510,6 +530,8 @@ public:
 	void AddIndustryToDeliver(Industry *ind, TileIndex tile);
 	void RemoveIndustryToDeliver(Industry *ind);
 	void RemoveFromAllNearbyLists();
+	void AddToCatchmentIndex();
+	void RemoveFromCatchmentIndex();
 
 	inline bool TileIsInCatchment(TileIndex tile) const
 	{
@@ -563,6 +585,8 @@ public:
 
 void RebuildStationKdtree();
 
+void FindStationsInCatchmentIndex(const TileArea &ta, std::vector<StationID> &stations);
+
 /**
  * Call a function on all stations that have any part of the requested area within their catchment.
  * @tparam Func The type of funcion to call
@@ -576,20 +600,13 @@ void ForAllStationsAroundTiles(const TileArea &ta, Func func)
 	/* There are no stations, so we will never find anything. */
 	if (Station::GetNumItems() == 0) return;
 
-	/* Not using, or don't have a nearby stations list, so we need to scan. */
-	std::set<StationID> seen_stations;
-
-	/* Scan an area around the building covering the maximum possible station
-	 * to find the possible nearby stations. */
-	uint max_c = _settings_game.station.modified_catchment ? MAX_CATCHMENT : CA_UNMODIFIED;
-	TileArea ta_ext = TileArea(ta).Expand(max_c);
-	for (TileIndex tile : ta_ext) {
-		if (IsTileType(tile, MP_STATION)) seen_stations.insert(GetStationIndex(tile));
-	}
+	/* Find the stations that cover any part of the map near the area, in the order of their index. */
+	std::vector<StationID> nearby_stations;
+	FindStationsInCatchmentIndex(ta, nearby_stations);
 
-	for (StationID stationid : seen_stations) {
+	for (StationID stationid : nearby_stations) {
 		Station *st = Station::GetIfValid(stationid);
-		if (st == nullptr) continue; /* Waypoint */
+		if (st == nullptr) continue;
 
 		/* Check if station is attached to an industry */
 		if (!_settings_game.station.serve_neutral_industries && st->industry != nullptr) continue;
@@ -19,6 +19,7 @@
 #include "ship.h"
 #include "roadveh.h"
 #include "industry.h"
+#include "object_map.h"
 #include "newgrf_cargo.h"
 #include "newgrf_debug.h"
 #include "newgrf_station.h"
@@ -59,6 +60,7 @@
 #include "waypoint_cmd.h"
 #include "landscape_cmd.h"
 #include "rail_cmd.h"
+#include <array>
 
 #include "table/strings.h"
 
@@ -562,24 +564,63 @@ CargoArray GetAcceptanceAroundTiles(TileIndex center_tile, int w, int h, int rad
 	return acceptance;
 }
 
+/**
+ * Check whether the acceptance of a tile only depends on what is built on it.
+ * Otherwise NewGRF callbacks, the industry or the company performance may
+ * change the acceptance without the tile itself changing.
+ * @param tile Tile to check.
+ * @return True iff the acceptance can only change when the tile is rebuilt.
+ */
+static bool IsTileAcceptanceFixed(TileIndex tile)
+{
+	if (IsTileType(tile, MP_HOUSE)) {
+		const HouseSpec *hs = HouseSpec::Get(GetHouseType(tile));
+		return !HasBit(hs->callback_mask, CBM_HOUSE_ACCEPT_CARGO) && !HasBit(hs->callback_mask, CBM_HOUSE_CARGO_ACCEPTANCE);
+	}
+
+	if (IsTileType(tile, MP_INDUSTRY)) {
+		const IndustryTileSpec *itspec = GetIndustryTileSpec(GetIndustryGfx(tile));
+		return (itspec->special_flags & INDTILE_SPECIAL_ACCEPTS_ALL_CARGO) == 0 &&
+				!HasBit(itspec->callback_mask, CBM_INDT_ACCEPT_CARGO) && !HasBit(itspec->callback_mask, CBM_INDT_CARGO_ACCEPTANCE);
+	}
+
+	/* The acceptance of the headquarters depends on their size. */
+	return !IsTileType(tile, MP_OBJECT) || !IsObjectType(tile, OBJECT_HQ);
+}
+
 /**
  * Get the acceptance of cargoes around the station in.
  * @param st Station to get acceptance of.
  * @param always_accepted bitmask of cargo accepted by houses and headquarters; can be nullptr
+ * @param[out] fixed Whether the acceptance of all tiles can only change when the tiles are rebuilt; can be nullptr
  */
-static CargoArray GetAcceptanceAroundStation(const Station *st, CargoTypes *always_accepted)
+static CargoArray GetAcceptanceAroundStation(const Station *st, CargoTypes *always_accepted, bool *fixed = nullptr)
 {
 	CargoArray acceptance;
 	if (always_accepted != nullptr) *always_accepted = 0;
+	if (fixed != nullptr) *fixed = true;
 
 	BitmapTileIterator it(st->catchment_tiles);
 	for (TileIndex tile = it; tile != INVALID_TILE; tile = ++it) {
 		AddAcceptedCargo(tile, acceptance, always_accepted);
+		if (fixed != nullptr && *fixed) *fixed = IsTileAcceptanceFixed(tile);
 	}
 
 	return acceptance;
 }
 
+/**
+ * Mark the cached acceptance of the stations around an area as outdated,
+ * as something that accepts cargo has been built or removed there.
+ * @param ta The changed area.
+ */
+void InvalidateStationAcceptance(const TileArea &ta)
+{
+	std::vector<StationID> stations;
+	FindStationsInCatchmentIndex(ta, stations);
+	for (StationID station : stations) Station::Get(station)->cached_acceptance_valid = false;
+}
+
 /**
  * Update the acceptance for a station.
  * @param st Station to update
@@ -590,10 +631,25 @@ void UpdateStationAcceptance(Station *st, bool show_msg)
 	/* old accepted goods types */
 	CargoTypes old_acc = GetAcceptanceMask(st);
 
-	/* And retrieve the acceptance. */
+	/* And retrieve the acceptance. When nothing in the catchment has been
+	 * rebuilt since the last time and none of the tiles may change their
+	 * acceptance by themselves, the previous result still holds. */
 	CargoArray acceptance;
 	if (!st->rect.IsEmpty()) {
-		acceptance = GetAcceptanceAroundStation(st, &st->always_accepted);
+		if (st->cached_acceptance_valid) {
+			acceptance = st->cached_acceptance;
+
+			if (_debug_desync_level > 1) {
+				CargoTypes always_accepted;
+				CargoArray check = GetAcceptanceAroundStation(st, &always_accepted);
+				if (MemCmpT(&check, &acceptance) != 0 || always_accepted != st->always_accepted) {
+					Debug(desync, 2, "station acceptance cache mismatch: station {}", st->index);
+				}
+			}
+		} else {
+			acceptance = GetAcceptanceAroundStation(st, &st->always_accepted, &st->cached_acceptance_valid);
+			st->cached_acceptance = acceptance;
+		}
 	}
 
 	/* Adjust in case our station only accepts fewer kinds of goods */
@@ -3612,12 +3668,17 @@ void DeleteStaleLinks(Station *from)
 		GoodsEntry &ge = from->goods[c];
 		LinkGraph *lg = LinkGraph::GetIfValid(ge.link_graph);
 		if (lg == nullptr) continue;
+		/* Refreshing links below may add edges and nodes, invalidating any
+		 * edge iterators. Remember the destinations to be checked instead. */
+		std::vector<NodeID> dests;
 		Node node = (*lg)[ge.node];
-		for (EdgeIterator it(node.Begin()); it != node.End();) {
-			Edge edge = it->second;
-			Station *to = Station::Get((*lg)[it->first].Station());
-			assert(to->goods[c].node == it->first);
-			++it; // Do that before removing the edge. Anything else may crash.
+		for (EdgeIterator it(node.Begin()); it != node.End(); ++it) {
+			dests.push_back(it->first);
+		}
+		for (NodeID dest : dests) {
+			Edge edge = (*lg)[ge.node][dest];
+			Station *to = Station::Get((*lg)[dest].Station());
+			assert(to->goods[c].node == dest);
 			assert(_date >= edge.LastUpdate());
 			uint timeout = LinkGraph::MIN_TIMEOUT_DISTANCE + (DistanceManhattan(from->xy, to->xy) >> 3);
 			if ((uint)(_date - edge.LastUpdate()) > timeout) {
@@ -3652,7 +3713,7 @@ void DeleteStaleLinks(Station *from)
 								LinkGraph::STALE_LINK_DEPOT_TIMEOUT) {
 							LinkRefresher::Run(v, false); // Don't allow merging. Otherwise lg might get deleted.
 						}
-						if (edge.LastUpdate() == _date) {
+						if ((*lg)[ge.node][dest].LastUpdate() == _date) {
 							updated = true;
 							break;
 						}
@@ -3671,7 +3732,7 @@ void DeleteStaleLinks(Station *from)
 
 				if (!updated) {
 					/* If it's still considered dead remove it. */
-					node.RemoveEdge(to->goods[c].node);
+					(*lg)[ge.node].RemoveEdge(dest);
 					ge.flows.DeleteFlows(to->index);
 					RerouteCargo(from, c, to->index, from->index);
 				}
@@ -3767,24 +3828,113 @@ void IncreaseStats(Station *st, const Vehicle *front, StationID next_station_id,
 	}
 }
 
-/* called for every station each tick */
-static void StationHandleSmallTick(BaseStation *st)
+/** Number of times OnTick_Station ran since the rating schedule was built; only differences of it matter. */
+static uint64 _station_tick_clock;
+/** Stations whose ratings are to be updated, in the slot of the value of #_station_tick_clock at which that is due. */
+static std::array<std::vector<StationID>, STATION_RATING_TICKS> _station_rating_schedule;
+
+/**
+ * Schedule the next rating update of a station that just got into use.
+ * The ratings are updated when the delete counter of the station has counted
+ * up to STATION_RATING_TICKS, one step each tick. Instead of counting, the
+ * tick of the update is computed from the counter once, and the counter is
+ * only brought up to date when the station is saved.
+ * @param st The station.
+ */
+void ScheduleStationRating(Station *st)
+{
+	st->next_rating_update = _station_tick_clock + std::max(1, STATION_RATING_TICKS - st->delete_ctr);
+	_station_rating_schedule[st->next_rating_update % STATION_RATING_TICKS].push_back(st->index);
+}
+
+/**
+ * Rebuild the rating schedule from the delete counters of the stations, e.g.\ after loading a game.
+ */
+void RebuildStationRatingSchedule()
+{
+	_station_tick_clock = 0;
+	for (auto &slot : _station_rating_schedule) slot.clear();
+
+	for (Station *st : Station::Iterate()) {
+		if (st->IsInUse()) ScheduleStationRating(st);
+	}
+}
+
+/**
+ * Set the delete counters of the stations in use to the values they would have
+ * had when they were counted up every tick, e.g.\ before saving the stations.
+ */
+void SyncStationRatingCounters()
+{
+	for (Station *st : Station::Iterate()) {
+		if (!st->IsInUse()) continue;
+
+		/* The update is always between 1 and STATION_RATING_TICKS ticks away. */
+		uint ticks_left = (uint)(st->next_rating_update - _station_tick_clock);
+		assert(ticks_left >= 1 && ticks_left <= STATION_RATING_TICKS);
+		st->delete_ctr = STATION_RATING_TICKS - ticks_left;
+	}
+}
+
+/**
+ * Update the ratings of a station if it is its turn.
+ * @param st The station.
+ * @param clock The current value of the station tick clock.
+ */
+static void StationHandleSmallTick(BaseStation *st, uint64 clock)
 {
 	if ((st->facilities & FACIL_WAYPOINT) != 0 || !st->IsInUse()) return;
 
-	byte b = st->delete_ctr + 1;
-	if (b >= STATION_RATING_TICKS) b = 0;
-	st->delete_ctr = b;
+	Station *station = Station::From(st);
+	if (station->next_rating_update != clock) return;
+
+	station->next_rating_update = clock + STATION_RATING_TICKS;
+	_station_rating_schedule[station->next_rating_update % STATION_RATING_TICKS].push_back(station->index);
+
+	UpdateStationRating(station);
+}
 
-	if (b == 0) UpdateStationRating(Station::From(st));
+/**
+ * Add the stations whose index is a multiple of the interval away from the given index.
+ * @param stations The list to add the stations to.
+ * @param first The lowest index.
+ * @param interval The distance between the indices.
+ */
+static void AddStationsAtInterval(std::vector<StationID> &stations, size_t first, size_t interval)
+{
+	for (size_t index = first; index < BaseStation::GetPoolSize(); index += interval) {
+		if (BaseStation::IsValidID(index)) stations.push_back((StationID)index);
+	}
 }
 
 void OnTick_Station()
 {
 	if (_game_mode == GM_EDITOR) return;
 
-	for (BaseStation *st : BaseStation::Iterate()) {
-		StationHandleSmallTick(st);
+	const uint64 clock = ++_station_tick_clock;
+
+	/* Only visit the stations that have something to do in this tick: the
+	 * ones with a rating update, and the ones with an index that makes this
+	 * the tick of one of their other periodic updates. They are handled in
+	 * the order of their index, as all random numbers have to be drawn in the
+	 * same order on all clients. */
+	static std::vector<StationID> stations;
+	std::vector<StationID> &slot = _station_rating_schedule[clock % STATION_RATING_TICKS];
+	stations.assign(slot.begin(), slot.end());
+	slot.clear();
+
+	AddStationsAtInterval(stations, (STATION_LINKGRAPH_TICKS - _tick_counter % STATION_LINKGRAPH_TICKS) % STATION_LINKGRAPH_TICKS, STATION_LINKGRAPH_TICKS);
+	AddStationsAtInterval(stations, (STATION_ACCEPTANCE_TICKS - _tick_counter % STATION_ACCEPTANCE_TICKS) % STATION_ACCEPTANCE_TICKS, STATION_ACCEPTANCE_TICKS);
+
+	std::sort(stations.begin(), stations.end());
+	stations.erase(std::unique(stations.begin(), stations.end()), stations.end());
+
+	for (StationID index : stations) {
+		/* Stations that got removed are still in the rating schedule. */
+		BaseStation *st = BaseStation::GetIfValid(index);
+		if (st == nullptr) continue;
+
+		StationHandleSmallTick(st, clock);
 
 		/* Clean up the link graph about once a week. */
 		if (Station::IsExpected(st) && (_tick_counter + st->index) % STATION_LINKGRAPH_TICKS == 0) {
@@ -3922,30 +4072,17 @@ CommandCost CmdRenameStation(DoCommandFlag flags, StationID station_id, const st
 	return CommandCost();
 }
 
-static void AddNearbyStationsByCatchment(TileIndex tile, StationList *stations, StationList &nearby)
-{
-	for (Station *st : nearby) {
-		if (st->TileIsInCatchment(tile)) stations->insert(st);
-	}
-}
-
 /**
- * Run a tile loop to find stations around a tile, on demand. Cache the result for further requests
+ * Find the stations around the area on demand, using the catchment index. Cache the result for further requests
  * @return pointer to a StationList containing all stations found
  */
 const StationList *StationFinder::GetStations()
 {
 	if (this->tile != INVALID_TILE) {
-		if (IsTileType(this->tile, MP_HOUSE)) {
-			/* Town nearby stations need to be filtered per tile. */
-			assert(this->w == 1 && this->h == 1);
-			AddNearbyStationsByCatchment(this->tile, &this->stations, Town::GetByTile(this->tile)->stations_near);
-		} else {
-			ForAllStationsAroundTiles(*this, [this](Station *st, TileIndex tile) {
-				this->stations.insert(st);
-				return true;
-			});
-		}
+		ForAllStationsAroundTiles(*this, [this](Station *st, TileIndex tile) {
+			this->stations.insert(st);
+			return true;
+		});
 		this->tile = INVALID_TILE;
 	}
 	return &this->stations;
@@ -4110,6 +4247,7 @@ void BuildOilRig(TileIndex tile)
 	st->ship_station.Add(tile);
 	st->facilities = FACIL_AIRPORT | FACIL_DOCK;
 	st->build_date = _date;
+	ScheduleStationRating(st);
 	UpdateStationDockingTiles(st);
 
 	st->rect.BeforeAddTile(tile, StationRect::ADD_FORCE);
@@ -4353,7 +4491,7 @@ StationID FlowStat::GetVia(StationID excluded, StationID excluded2) const
 {
 	if (this->unrestricted == 0) return INVALID_STATION;
 	assert(!this->shares.empty());
-	SharesMap::const_iterator it = this->shares.upper_bound(RandomRange(this->unrestricted));
+	SharesMap::const_iterator it = this->UpperBound(RandomRange(this->unrestricted));
 	assert(it != this->shares.end() && it->first <= this->unrestricted);
 	if (it->second != excluded && it->second != excluded2) return it->second;
 
@@ -4366,8 +4504,8 @@ StationID FlowStat::GetVia(StationID excluded, StationID excluded2) const
 	if (interval >= this->unrestricted) return INVALID_STATION; // Only one station in the map.
 	uint new_max = this->unrestricted - interval;
 	uint rand = RandomRange(new_max);
-	SharesMap::const_iterator it2 = (rand < begin) ? this->shares.upper_bound(rand) :
-			this->shares.upper_bound(rand + interval);
+	SharesMap::const_iterator it2 = (rand < begin) ? this->UpperBound(rand) :
+			this->UpperBound(rand + interval);
 	assert(it2 != this->shares.end() && it2->first <= this->unrestricted);
 	if (it2->second != excluded && it2->second != excluded2) return it2->second;
 
@@ -4385,13 +4523,13 @@ StationID FlowStat::GetVia(StationID excluded, StationID excluded2) const
 		Swap(interval, interval2);
 	}
 	rand = RandomRange(new_max);
-	SharesMap::const_iterator it3 = this->shares.upper_bound(this->unrestricted);
+	SharesMap::const_iterator it3 = this->UpperBound(this->unrestricted);
 	if (rand < begin) {
-		it3 = this->shares.upper_bound(rand);
+		it3 = this->UpperBound(rand);
 	} else if (rand < begin2 - interval) {
-		it3 = this->shares.upper_bound(rand + interval);
+		it3 = this->UpperBound(rand + interval);
 	} else {
-		it3 = this->shares.upper_bound(rand + interval + interval2);
+		it3 = this->UpperBound(rand + interval + interval2);
 	}
 	assert(it3 != this->shares.end() && it3->first <= this->unrestricted);
 	return it3->second;
@@ -4406,13 +4544,14 @@ void FlowStat::Invalidate()
 {
 	assert(!this->shares.empty());
 	SharesMap new_shares;
+	new_shares.reserve(this->shares.size());
 	uint i = 0;
 	for (SharesMap::iterator it(this->shares.begin()); it != this->shares.end(); ++it) {
-		new_shares[++i] = it->second;
+		new_shares.emplace_back(++i, it->second);
 		if (it->first == this->unrestricted) this->unrestricted = i;
 	}
 	this->shares.swap(new_shares);
-	assert(!this->shares.empty() && this->unrestricted <= (--this->shares.end())->first);
+	assert(!this->shares.empty() && this->unrestricted <= this->shares.back().first);
 }
 
 /**
@@ -4431,6 +4570,7 @@ void FlowStat::ChangeShare(StationID st, int flow)
 	uint added_shares = 0;
 	uint last_share = 0;
 	SharesMap new_shares;
+	new_shares.reserve(this->shares.size() + 1);
 	for (SharesMap::iterator it(this->shares.begin()); it != this->shares.end(); ++it) {
 		if (it->second == st) {
 			if (flow < 0) {
@@ -4452,11 +4592,11 @@ void FlowStat::ChangeShare(StationID st, int flow)
 			 * removed. */
 			flow = 0;
 		}
-		new_shares[it->first + added_shares - removed_shares] = it->second;
+		new_shares.emplace_back(it->first + added_shares - removed_shares, it->second);
 		last_share = it->first;
 	}
 	if (flow > 0) {
-		new_shares[last_share + (uint)flow] = st;
+		new_shares.emplace_back(last_share + (uint)flow, st);
 		if (this->unrestricted < last_share) {
 			this->ReleaseShare(st);
 		} else {
@@ -4477,6 +4617,7 @@ void FlowStat::RestrictShare(StationID st)
 	uint flow = 0;
 	uint last_share = 0;
 	SharesMap new_shares;
+	new_shares.reserve(this->shares.size());
 	for (SharesMap::iterator it(this->shares.begin()); it != this->shares.end(); ++it) {
 		if (flow == 0) {
 			if (it->first > this->unrestricted) return; // Not present or already restricted.
@@ -4484,15 +4625,15 @@ void FlowStat::RestrictShare(StationID st)
 				flow = it->first - last_share;
 				this->unrestricted -= flow;
 			} else {
-				new_shares[it->first] = it->second;
+				new_shares.emplace_back(it->first, it->second);
 			}
 		} else {
-			new_shares[it->first - flow] = it->second;
+			new_shares.emplace_back(it->first - flow, it->second);
 		}
 		last_share = it->first;
 	}
 	if (flow == 0) return;
-	new_shares[last_share + flow] = st;
+	new_shares.emplace_back(last_share + flow, st);
 	this->shares.swap(new_shares);
 	assert(!this->shares.empty());
 }
@@ -4522,10 +4663,11 @@ void FlowStat::ReleaseShare(StationID st)
 	}
 	if (flow == 0) return;
 	SharesMap new_shares;
-	new_shares[flow] = st;
+	new_shares.reserve(this->shares.size());
+	new_shares.emplace_back(flow, st);
 	for (SharesMap::iterator it(this->shares.begin()); it != this->shares.end(); ++it) {
 		if (it->second != st) {
-			new_shares[flow + it->first] = it->second;
+			new_shares.emplace_back(flow + it->first, it->second);
 		} else {
 			flow = 0;
 		}
@@ -4543,10 +4685,11 @@ void FlowStat::ScaleToMonthly(uint runtime)
 {
 	assert(runtime > 0);
 	SharesMap new_shares;
+	new_shares.reserve(this->shares.size());
 	uint share = 0;
 	for (SharesMap::iterator i = this->shares.begin(); i != this->shares.end(); ++i) {
 		share = std::max(share + 1, i->first * 30 / runtime);
-		new_shares[share] = i->second;
+		new_shares.emplace_back(share, i->second);
 		if (this->unrestricted == i->first) this->unrestricted = share;
 	}
 	this->shares.swap(new_shares);
@@ -0,0 +1,152 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file thread_pool.cpp Pool of worker threads to spread independent work items over. */
+
+#include "stdafx.h"
+#include "thread.h"
+#include "thread_pool.h"
+#include <atomic>
+#include <condition_variable>
+#include <vector>
+
+#include "safeguards.h"
+
+/**
+ * Worker threads waiting for a ParallelFor to help with.
+ * The threads are started on first use and stopped when the game exits.
+ */
+static struct WorkerPool {
+	std::mutex lock;                                   ///< Protects the members below, except #next and #finished.
+	std::condition_variable wake;                      ///< Signalled when new work is available or the pool stops.
+	std::condition_variable done;                      ///< Signalled when a worker is finished with the current work.
+	std::vector<std::thread> threads;                  ///< The worker threads.
+	bool started = false;                              ///< Whether the workers have been started.
+	bool exit = false;                                 ///< Whether the workers have to stop.
+	uint generation = 0;                               ///< Increased for every new ParallelFor.
+	uint busy = 0;                                     ///< Number of workers running items of the current ParallelFor.
+	const std::function<void(uint)> *func = nullptr;   ///< Function of the current ParallelFor, or nullptr.
+	uint count = 0;                                    ///< Number of items of the current ParallelFor.
+	std::atomic<uint> next;                            ///< Next item to be run.
+	std::atomic<uint> finished;                        ///< Number of items that have been run.
+
+	~WorkerPool()
+	{
+		{
+			std::lock_guard<std::mutex> guard(this->lock);
+			this->exit = true;
+		}
+		this->wake.notify_all();
+		for (std::thread &t : this->threads) t.join();
+	}
+} _worker_pool;
+
+/** Only one ParallelFor can use the workers at a time; others run on their own thread. */
+static std::mutex _parallel_for_lock;
+
+/**
+ * Run items of the current ParallelFor until none are left.
+ * @param func Function to run.
+ * @param count Number of items.
+ */
+static void RunWorkItems(const std::function<void(uint)> &func, uint count)
+{
+	for (uint i = _worker_pool.next.fetch_add(1); i < count; i = _worker_pool.next.fetch_add(1)) {
+		func(i);
+		_worker_pool.finished.fetch_add(1, std::memory_order_release);
+	}
+}
+
+/** Main loop of a worker thread. */
+static void WorkerThread()
+{
+	std::unique_lock<std::mutex> lock(_worker_pool.lock);
+	uint seen = _worker_pool.generation;
+	for (;;) {
+		_worker_pool.wake.wait(lock, [&seen] { return _worker_pool.exit || _worker_pool.generation != seen; });
+		if (_worker_pool.exit) return;
+		seen = _worker_pool.generation;
+
+		/* Woken up too late; the work is already done. */
+		if (_worker_pool.func == nullptr) continue;
+
+		const std::function<void(uint)> &func = *_worker_pool.func;
+		uint count = _worker_pool.count;
+		_worker_pool.busy++;
+		lock.unlock();
+
+		RunWorkItems(func, count);
+
+		lock.lock();
+		if (--_worker_pool.busy == 0) _worker_pool.done.notify_all();
+	}
+}
+
+/**
+ * Start the worker threads, one less than the number of cores as the
+ * thread calling ParallelFor works as well.
+ */
+static void StartWorkerThreads()
+{
+	_worker_pool.started = true;
+
+	uint cores = std::thread::hardware_concurrency();
+	for (uint i = 1; i < cores; i++) {
+		std::thread t;
+		if (!StartNewThread(&t, "ottd:worker", &WorkerThread)) break;
+		_worker_pool.threads.push_back(std::move(t));
+	}
+
+	Debug(misc, 1, "Started {} worker threads", _worker_pool.threads.size());
+}
+
+/**
+ * Get the number of threads that run the items of a ParallelFor.
+ * @return Number of worker threads plus the calling thread.
+ */
+uint GetWorkerThreadCount()
+{
+	std::lock_guard<std::mutex> guard(_worker_pool.lock);
+	if (!_worker_pool.started) StartWorkerThreads();
+	return (uint)_worker_pool.threads.size() + 1;
+}
+
+/**
+ * Call a function for every item in [0, count) using the worker threads.
+ * The items are run in no particular order and possibly at the same time,
+ * so they must not depend on each other; write results to a slot per item
+ * and merge them afterwards in item order to keep the result independent
+ * of the number of threads. Returns when all items have been run.
+ * When the workers are busy, e.g. for a nested call, the items are run on
+ * the calling thread.
+ * @param count Number of items.
+ * @param func Function to call with the index of each item.
+ */
+void ParallelFor(uint count, const std::function<void(uint)> &func)
+{
+	std::unique_lock<std::mutex> exclusive(_parallel_for_lock, std::try_to_lock);
+	if (count < 2 || !exclusive.owns_lock() || GetWorkerThreadCount() == 1) {
+		for (uint i = 0; i < count; i++) func(i);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(_worker_pool.lock);
+		_worker_pool.func = &func;
+		_worker_pool.count = count;
+		_worker_pool.next.store(0);
+		_worker_pool.finished.store(0);
+		_worker_pool.generation++;
+	}
+	_worker_pool.wake.notify_all();
+
+	RunWorkItems(func, count);
+
+	std::unique_lock<std::mutex> lock(_worker_pool.lock);
+	_worker_pool.done.wait(lock, [count] { return _worker_pool.busy == 0 && _worker_pool.finished.load(std::memory_order_acquire) == count; });
+	_worker_pool.func = nullptr;
+}
@@ -18,6 +18,7 @@
 #include "industry.h"
 #include "station_base.h"
 #include "station_kdtree.h"
+#include "station_func.h"
 #include "company_base.h"
 #include "news_func.h"
 #include "error.h"
@@ -28,6 +29,7 @@
 #include "newgrf_text.h"
 #include "autoslope.h"
 #include "tunnelbridge_map.h"
+#include "screenshot.h"
 #include "strings_func.h"
 #include "window_func.h"
 #include "string_func.h"
@@ -146,6 +148,7 @@ Town::~Town()
 	DeleteSubsidyWith(ST_TOWN, this->index);
 	DeleteNewGRFInspectWindow(GSF_FAKE_TOWNS, this->index);
 	CargoPacket::InvalidateAllFrom(ST_TOWN, this->index);
+	InvalidateMapTiles();
 	MarkWholeScreenDirty();
 }
 
@@ -2309,10 +2312,12 @@ static void MakeTownHouse(TileIndex t, Town *town, byte counter, byte stage, Hou
 	if (size & BUILDING_2_TILES_X)   ClearMakeHouseTile(t + TileDiffXY(1, 0), town, counter, stage, ++type, random_bits);
 	if (size & BUILDING_HAS_4_TILES) ClearMakeHouseTile(t + TileDiffXY(1, 1), town, counter, stage, ++type, random_bits);
 
-	ForAllStationsAroundTiles(TileArea(t, (size & BUILDING_2_TILES_X) ? 2 : 1, (size & BUILDING_2_TILES_Y) ? 2 : 1), [town](Station *st, TileIndex tile) {
+	TileArea ta(t, (size & BUILDING_2_TILES_X) ? 2 : 1, (size & BUILDING_2_TILES_Y) ? 2 : 1);
+	ForAllStationsAroundTiles(ta, [town](Station *st, TileIndex tile) {
 		town->stations_near.insert(st);
 		return true;
 	});
+	InvalidateStationAcceptance(ta);
 }
 
 
@@ -2498,6 +2503,57 @@ static bool CheckTownBuild2x2House(TileIndex *tile, Town *t, int maxz, bool nosl
 }
 
 
+/** Houses that match a town zone and climate, see #GetHouseCandidates. */
+struct HouseCandidates {
+	bool valid = false;          ///< Whether #houses matches the current house specs.
+	std::vector<HouseID> houses; ///< Matching houses, in ascending house ID order.
+};
+
+/** Cached house candidates per town zone and climate; the climate is offset by one to include the above snowline one. */
+static HouseCandidates _house_candidates[HZB_END][NUM_LANDSCAPE + 1];
+
+/** Forget the cached house candidates, as the house specs are about to change. */
+static void InvalidateHouseCandidates()
+{
+	for (auto &zone : _house_candidates) {
+		for (HouseCandidates &candidates : zone) {
+			candidates.valid = false;
+			candidates.houses.clear();
+		}
+	}
+}
+
+/**
+ * Get the houses whose availability matches the town zone and climate of a tile.
+ * The house specs do not change while a game is running, so the list is only
+ * built once instead of scanning all #NUM_HOUSES specs for every house the
+ * towns try to build.
+ * @param rad The town zone of the tile.
+ * @param land The climate of the tile, or -1 when it is above the snowline.
+ * @return The enabled and not overridden houses for this zone and climate.
+ */
+static const std::vector<HouseID> &GetHouseCandidates(HouseZonesBits rad, int land)
+{
+	HouseCandidates &candidates = _house_candidates[rad][land + 1];
+	if (candidates.valid) return candidates.houses;
+
+	/* bits 0-4 are used
+	 * bits 11-15 are used
+	 * bits 5-10 are not used. */
+	uint bitmask = (1 << rad) + (1 << (land + 12));
+
+	for (uint i = 0; i < NUM_HOUSES; i++) {
+		const HouseSpec *hs = HouseSpec::Get(i);
+
+		/* Verify that the candidate house spec matches the current tile status */
+		if ((~hs->building_availability & bitmask) != 0 || !hs->enabled || hs->grf_prop.override != INVALID_HOUSE_ID) continue;
+
+		candidates.houses.push_back((HouseID)i);
+	}
+	candidates.valid = true;
+	return candidates.houses;
+}
+
 /**
  * Tries to build a house at this tile
  * @param t town the house will belong to
@@ -2523,23 +2579,15 @@ static bool BuildTownHouse(Town *t, TileIndex tile)
 	int land = _settings_game.game_creation.landscape;
 	if (land == LT_ARCTIC && maxz > HighestSnowLine()) land = -1;
 
-	uint bitmask = (1 << rad) + (1 << (land + 12));
-
-	/* bits 0-4 are used
-	 * bits 11-15 are used
-	 * bits 5-10 are not used. */
 	HouseID houses[NUM_HOUSES];
 	uint num = 0;
 	uint probs[NUM_HOUSES];
 	uint probability_max = 0;
 
 	/* Generate a list of all possible houses that can be built. */
-	for (uint i = 0; i < NUM_HOUSES; i++) {
+	for (HouseID i : GetHouseCandidates(rad, land)) {
 		const HouseSpec *hs = HouseSpec::Get(i);
 
-		/* Verify that the candidate house spec matches the current tile status */
-		if ((~hs->building_availability & bitmask) != 0 || !hs->enabled || hs->grf_prop.override != INVALID_HOUSE_ID) continue;
-
 		/* Don't let these counters overflow. Global counters are 32bit, there will never be that many houses. */
 		if (hs->class_id != HOUSE_NO_CLASS) {
 			/* id_count is always <= class_count, so it doesn't need to be checked */
@@ -2552,7 +2600,7 @@ static bool BuildTownHouse(Town *t, TileIndex tile)
 		uint cur_prob = hs->probability;
 		probability_max += cur_prob;
 		probs[num] = cur_prob;
-		houses[num++] = (HouseID)i;
+		houses[num++] = i;
 	}
 
 	TileIndex baseTile = tile;
@@ -2727,6 +2775,7 @@ void ClearTownHouse(Town *t, TileIndex tile)
 	if (hs->building_flags & BUILDING_HAS_4_TILES) DoClearTownHouseHelper(tile + TileDiffXY(1, 1), t, ++house);
 
 	RemoveNearbyStations(t, tile, hs->building_flags);
+	InvalidateStationAcceptance(TileArea(tile, (hs->building_flags & BUILDING_2_TILES_X) ? 2 : 1, (hs->building_flags & BUILDING_2_TILES_Y) ? 2 : 1));
 
 	UpdateTownRadius(t);
 }
@@ -3716,9 +3765,16 @@ CommandCost CheckforTownRating(DoCommandFlag flags, Town *t, TownRatingCheckType
 	return CommandCost();
 }
 
-void TownsMonthlyLoop()
+/**
+ * Monthly loop for the towns whose index modulo #DAY_TICKS equals the step.
+ * @param step The tick of the first day of the month.
+ */
+void TownsMonthlyLoopStep(uint step)
 {
-	for (Town *t : Town::Iterate()) {
+	for (size_t index = step; index < Town::GetPoolSize(); index += DAY_TICKS) {
+		Town *t = Town::GetIfValid(index);
+		if (t == nullptr) continue;
+
 		if (t->road_build_months != 0) t->road_build_months--;
 
 		if (t->exclusive_counter != 0) {
@@ -3733,10 +3789,17 @@ void TownsMonthlyLoop()
 
 }
 
-void TownsYearlyLoop()
+/**
+ * Yearly loop for the part of the map that belongs to the step.
+ * @param step The tick of the first day of the year.
+ */
+void TownsYearlyLoopStep(uint step)
 {
+	TileIndex begin = (uint)((uint64)tile_map.size * step / DAY_TICKS);
+	TileIndex end = (uint)((uint64)tile_map.size * (step + 1) / DAY_TICKS);
+
 	/* Increment house ages */
-	for (TileIndex t = 0; t < tile_map.size; t++) {
+	for (TileIndex t = begin; t < end; t++) {
 		if (!IsTileType(t, MP_HOUSE)) continue;
 		IncrementHouseAge(t);
 	}
@@ -3798,4 +3861,6 @@ void ResetHouses()
 
 	/* Reset any overrides that have been set. */
 	_house_mngr.ResetOverride();
+
+	InvalidateHouseCandidates();
 }
@@ -354,6 +354,7 @@ Vehicle::Vehicle(VehicleType type)
 	this->cargo_age_counter  = 1;
 	this->last_station_visited = INVALID_STATION;
 	this->last_loading_station = INVALID_STATION;
+	this->hash_tile_train    = INVALID_TILE;
 }
 
 /**
@@ -611,6 +612,15 @@ CommandCost EnsureNoTrainOnTrackBits(TileIndex tile, TrackBits track_bits)
 
 static void UpdateVehicleTileHash(Vehicle *v, bool remove)
 {
+	if (v->type == VEH_TRAIN) {
+		/* Keep the occupancy counters of the signal blocks in sync with the tile hash. */
+		TileIndex tile = remove ? INVALID_TILE : v->tile;
+		if (tile != v->hash_tile_train) {
+			MoveTrainInSignalBlocks(v->hash_tile_train, tile);
+			v->hash_tile_train = tile;
+		}
+	}
+
 	Vehicle **old_hash = v->hash_tile_current;
 	Vehicle **new_hash;
 
@@ -1152,6 +1162,8 @@ void ViewportAddVehicles(DrawPixelInfo *dpi)
 		yu = GEN_HASHY_MASK;
 	}
 
+	const bool prefetch = IsSpritePrefetching();
+
 	for (int y = yl;; y = (y + GEN_HASHY_INC) & GEN_HASHY_MASK) {
 		for (int x = xl;; x = (x + GEN_HASHX_INC) & GEN_HASHX_MASK) {
 			const Vehicle *v = _vehicle_viewport_hash[x + y]; // already masked & 0xFFF
@@ -1164,36 +1176,44 @@ void ViewportAddVehicles(DrawPixelInfo *dpi)
 					r >= v->coord.left - xb &&
 					b >= v->coord.top - yb)
 				{
-					/*
-					 * This vehicle can potentially be drawn as part of this viewport and
-					 * needs to be revalidated, as the sprite may not be correct.
-					 */
-					if (v->sprite_cache.revalidate_before_draw) {
-						VehicleSpriteSeq seq;
-						v->GetImage(v->direction, EIT_ON_MAP, &seq);
-
-						if (seq.IsValid() && v->sprite_cache.sprite_seq != seq) {
-							v->sprite_cache.sprite_seq = seq;
-							/*
-							 * A sprite change may also result in a bounding box change,
-							 * so we need to update the bounding box again before we
-							 * check to see if the vehicle should be drawn. Note that
-							 * we can't interfere with the viewport hash at this point,
-							 * so we keep the original hash on the assumption there will
-							 * not be a significant change in the top and left coordinates
-							 * of the vehicle.
-							 */
-							v->UpdateBoundingBoxCoordinates(false);
+					if (prefetch) {
+						/* Only queue the sprites the vehicle already has. Revalidating them now
+						 * would measure the placeholders of the sprites that are not cached. */
+						for (uint i = 0; i < v->sprite_cache.sprite_seq.count; ++i) {
+							GetSprite(v->sprite_cache.sprite_seq.seq[i].sprite & SPRITE_MASK, ST_NORMAL);
+						}
+					} else {
+						/*
+						 * This vehicle can potentially be drawn as part of this viewport and
+						 * needs to be revalidated, as the sprite may not be correct.
+						 */
+						if (v->sprite_cache.revalidate_before_draw) {
+							VehicleSpriteSeq seq;
+							v->GetImage(v->direction, EIT_ON_MAP, &seq);
+
+							if (seq.IsValid() && v->sprite_cache.sprite_seq != seq) {
+								v->sprite_cache.sprite_seq = seq;
+								/*
+								 * A sprite change may also result in a bounding box change,
+								 * so we need to update the bounding box again before we
+								 * check to see if the vehicle should be drawn. Note that
+								 * we can't interfere with the viewport hash at this point,
+								 * so we keep the original hash on the assumption there will
+								 * not be a significant change in the top and left coordinates
+								 * of the vehicle.
+								 */
+								v->UpdateBoundingBoxCoordinates(false);
 
+							}
+
+							v->sprite_cache.revalidate_before_draw = false;
 						}
 
-						v->sprite_cache.revalidate_before_draw = false;
+						if (l <= v->coord.right &&
+							t <= v->coord.bottom &&
+							r >= v->coord.left &&
+							b >= v->coord.top) DoDrawVehicle(v);
 					}
-
-					if (l <= v->coord.right &&
-						t <= v->coord.bottom &&
-						r >= v->coord.left &&
-						b >= v->coord.top) DoDrawVehicle(v);
 				}
 
 				v = v->hash_viewport_next;
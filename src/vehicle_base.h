@@ -265,6 +265,7 @@ public:
 	Vehicle *hash_tile_next;            ///< NOSAVE: Next vehicle in the tile location hash.
 	Vehicle **hash_tile_prev;           ///< NOSAVE: Previous vehicle in the tile location hash.
 	Vehicle **hash_tile_current;        ///< NOSAVE: Cache of the current hash chain.
+	TileIndex hash_tile_train;          ///< NOSAVE: Tile a train vehicle is counted on for signal block occupancy.
 
 	SpriteID colourmap;                 ///< NOSAVE: cached colour mapping
 
@@ -89,6 +89,10 @@
 #include "network/network_func.h"
 #include "framerate_type.h"
 #include "viewport_cmd.h"
+#include "spritecache.h"
+#include "thread_pool.h"
+#include "screenshot.h"
+#include "smallmap_gui.h"
 
 #include <forward_list>
 #include <map>
@@ -184,6 +188,9 @@ static bool MarkViewportDirty(const Viewport *vp, int left, int top, int right,
 
 static ViewportDrawer _vd;
 
+static const int VIEWPORT_DRAW_BAND_HEIGHT = 256; ///< Height in pixels of the bands a viewport is drawn in.
+static std::vector<ViewportDrawer> _vd_bands;     ///< Sprites collected for each band, kept to reuse their buffers.
+
 TileHighlightData _thd;
 static TileInfo *_cur_ti;
 bool _draw_bounding_boxes = false;
@@ -259,6 +266,7 @@ void InitializeWindowViewport(Window *w, int x, int y,
 	vp->dest_scrollpos_y = pt.y;
 
 	vp->overlay = nullptr;
+	vp->prefetch_zoom = ZOOM_LVL_END;
 
 	w->viewport = vp;
 	vp->virtual_left = 0; // pt.x;
@@ -1716,7 +1724,15 @@ static void ViewportDrawStrings(ZoomLevel zoom, const StringSpriteToDrawVector *
 	}
 }
 
-void ViewportDoDraw(const Viewport *vp, int left, int top, int right, int bottom)
+/**
+ * Collect the sprites of the given area of a viewport into #_vd.
+ * @param vp Viewport to collect the sprites of.
+ * @param left Left edge of the area in viewport coordinates.
+ * @param top Top edge of the area in viewport coordinates.
+ * @param right Right edge of the area in viewport coordinates.
+ * @param bottom Bottom edge of the area in viewport coordinates.
+ */
+static void ViewportCollectSprites(const Viewport *vp, int left, int top, int right, int bottom)
 {
 	DrawPixelInfo *old_dpi = _cur_dpi;
 	_cur_dpi = &_vd.dpi;
@@ -1745,13 +1761,28 @@ void ViewportDoDraw(const Viewport *vp, int left, int top, int right, int bottom
 
 	DrawTextEffects(&_vd.dpi);
 
-	if (_vd.tile_sprites_to_draw.size() != 0) ViewportDrawTileSprites(&_vd.tile_sprites_to_draw);
-
 	for (auto &psd : _vd.parent_sprites_to_draw) {
 		_vd.parent_sprites_to_sort.push_back(&psd);
 	}
 
-	_vp_sprite_sorter(&_vd.parent_sprites_to_sort);
+	_cur_dpi = old_dpi;
+}
+
+/**
+ * Draw the sprites collected in #_vd, after the parent sprites have been sorted.
+ * @param vp Viewport the sprites were collected for.
+ */
+static void ViewportDrawSortedSprites(const Viewport *vp)
+{
+	DrawPixelInfo *old_dpi = _cur_dpi;
+	_cur_dpi = &_vd.dpi;
+
+	int mask = ScaleByZoom(-1, vp->zoom);
+	int x = UnScaleByZoom(_vd.dpi.left - (vp->virtual_left & mask), vp->zoom) + vp->left;
+	int y = UnScaleByZoom(_vd.dpi.top - (vp->virtual_top & mask), vp->zoom) + vp->top;
+
+	if (_vd.tile_sprites_to_draw.size() != 0) ViewportDrawTileSprites(&_vd.tile_sprites_to_draw);
+
 	ViewportDrawParentSprites(&_vd.parent_sprites_to_sort, &_vd.child_screen_sprites_to_draw);
 
 	if (_draw_bounding_boxes) ViewportDrawBoundingBoxes(&_vd.parent_sprites_to_sort);
@@ -1787,6 +1818,13 @@ void ViewportDoDraw(const Viewport *vp, int left, int top, int right, int bottom
 	_vd.child_screen_sprites_to_draw.clear();
 }
 
+void ViewportDoDraw(const Viewport *vp, int left, int top, int right, int bottom)
+{
+	ViewportCollectSprites(vp, left, top, right, bottom);
+	_vp_sprite_sorter(&_vd.parent_sprites_to_sort);
+	ViewportDrawSortedSprites(vp);
+}
+
 static inline void ViewportDraw(const Viewport *vp, int left, int top, int right, int bottom)
 {
 	if (right <= vp->left || bottom <= vp->top) return;
@@ -1801,12 +1839,78 @@ static inline void ViewportDraw(const Viewport *vp, int left, int top, int right
 	if (top < vp->top) top = vp->top;
 	if (bottom > vp->top + vp->height) bottom = vp->top + vp->height;
 
-	ViewportDoDraw(vp,
-		ScaleByZoom(left - vp->left, vp->zoom) + vp->virtual_left,
-		ScaleByZoom(top - vp->top, vp->zoom) + vp->virtual_top,
-		ScaleByZoom(right - vp->left, vp->zoom) + vp->virtual_left,
-		ScaleByZoom(bottom - vp->top, vp->zoom) + vp->virtual_top
-	);
+	/* Split the area into horizontal bands aligned to the screen, so the
+	 * sprites of each band, and thus the result, don't depend on the number
+	 * of worker threads. Collecting sprites calls into the tile and vehicle
+	 * code, and drawing into the sprite cache, so only sorting is done in
+	 * parallel. */
+	uint num_bands = 0;
+	for (int band_top = top; band_top < bottom;) {
+		int band_bottom = std::min(bottom, (band_top / VIEWPORT_DRAW_BAND_HEIGHT + 1) * VIEWPORT_DRAW_BAND_HEIGHT);
+
+		ViewportCollectSprites(vp,
+			ScaleByZoom(left - vp->left, vp->zoom) + vp->virtual_left,
+			ScaleByZoom(band_top - vp->top, vp->zoom) + vp->virtual_top,
+			ScaleByZoom(right - vp->left, vp->zoom) + vp->virtual_left,
+			ScaleByZoom(band_bottom - vp->top, vp->zoom) + vp->virtual_top
+		);
+
+		if (num_bands == _vd_bands.size()) _vd_bands.emplace_back();
+		std::swap(_vd, _vd_bands[num_bands++]);
+		band_top = band_bottom;
+	}
+
+	ParallelFor(num_bands, [](uint i) {
+		_vp_sprite_sorter(&_vd_bands[i].parent_sprites_to_sort);
+	});
+
+	for (uint i = 0; i < num_bands; i++) {
+		std::swap(_vd, _vd_bands[i]);
+		ViewportDrawSortedSprites(vp);
+	}
+}
+
+/**
+ * Queue the sprites around a viewport for decoding in the background, so they
+ * are ready when the viewport scrolls. The area is twice the size of the
+ * viewport, which is also what becomes visible when zooming out one level.
+ * Sprites are collected like for drawing, but missing ones are only queued.
+ * This is only redone after the viewport moved a quarter of its size.
+ * @param vp The viewport.
+ */
+static void ViewportPrefetchSprites(ViewportData *vp)
+{
+	int centre_x = vp->virtual_left + vp->virtual_width / 2;
+	int centre_y = vp->virtual_top + vp->virtual_height / 2;
+	if (vp->prefetch_zoom == vp->zoom &&
+			abs(centre_x - vp->prefetch_x) < vp->virtual_width / 4 &&
+			abs(centre_y - vp->prefetch_y) < vp->virtual_height / 4) {
+		return;
+	}
+
+	if (!BeginSpritePrefetch()) return;
+
+	vp->prefetch_x = centre_x;
+	vp->prefetch_y = centre_y;
+	vp->prefetch_zoom = vp->zoom;
+
+	/* Nothing is drawn, but collecting needs a destination. */
+	DrawPixelInfo dpi = {};
+	dpi.dst_ptr = _screen.dst_ptr;
+	dpi.pitch = _screen.pitch;
+	DrawPixelInfo *old_dpi = _cur_dpi;
+	_cur_dpi = &dpi;
+
+	ViewportCollectSprites(vp, centre_x - vp->virtual_width, centre_y - vp->virtual_height, centre_x + vp->virtual_width, centre_y + vp->virtual_height);
+
+	_cur_dpi = old_dpi;
+	EndSpritePrefetch();
+
+	_vd.string_sprites_to_draw.clear();
+	_vd.tile_sprites_to_draw.clear();
+	_vd.parent_sprites_to_draw.clear();
+	_vd.parent_sprites_to_sort.clear();
+	_vd.child_screen_sprites_to_draw.clear();
 }
 
 /**
@@ -1899,6 +2003,8 @@ void UpdateViewportPosition(Window *w)
 		SetViewportPosition(w, w->viewport->scrollpos_x, w->viewport->scrollpos_y);
 		if (update_overlay) RebuildViewportOverlay(w);
 	}
+
+	ViewportPrefetchSprites(w->viewport);
 }
 
 /**
@@ -1952,6 +2058,8 @@ static bool MarkViewportDirty(const Viewport *vp, int left, int top, int right,
  */
 bool MarkAllViewportsDirty(int left, int top, int right, int bottom)
 {
+	MarkMapTilesDirty(left, top, right, bottom);
+
 	bool dirty = false;
 
 	for (const Window *w : Window::Iterate()) {
@@ -1987,6 +2095,8 @@ void ConstrainAllViewportsZoom()
  */
 void MarkTileDirtyByTile(TileIndex tile, int bridge_level_offset, int tile_height_override)
 {
+	MarkSmallMapTileDirty(tile);
+
 	Point pt = RemapCoords(TileX(tile) * TILE_SIZE, TileY(tile) * TILE_SIZE, tile_height_override * TILE_HEIGHT);
 	MarkAllViewportsDirty(
 			pt.x - MAX_TILE_EXTENT_LEFT,
@@ -53,7 +53,8 @@ static void GetTileDesc_Void(TileIndex tile, TileDesc *td)
 
 static void TileLoop_Void(TileIndex tile)
 {
-	/* not used */
+	/* Nothing to do, ever. */
+	tile_map.inert_tiles[tile] = true;
 }
 
 static void ChangeTileOwner_Void(TileIndex tile, Owner old_owner, Owner new_owner)
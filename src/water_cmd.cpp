@@ -1220,13 +1220,17 @@ void TileLoop_Water(TileIndex tile)
 	if (IsTileType(tile, MP_WATER)) AmbientSoundEffect(tile);
 
 	switch (GetFloodingBehaviour(tile)) {
-		case FLOOD_ACTIVE:
+		case FLOOD_ACTIVE: {
+			/* Sea surrounded by water has nothing to flood until one of the tiles around it changes. */
+			bool inert = IsTileType(tile, MP_WATER) && !IsCoast(tile);
 			for (Direction dir = DIR_BEGIN; dir < DIR_END; dir++) {
 				TileIndex dest = tile + TileOffsByDir(dir);
 				if (!IsValidTile(dest)) continue;
 				/* do not try to flood water tiles - increases performance a lot */
 				if (IsTileType(dest, MP_WATER)) continue;
 
+				inert = false;
+
 				/* TREE_GROUND_SHORE is the sign of a previous flood. */
 				if (IsTileType(dest, MP_TREES) && GetTreeGround(dest) == TREE_GROUND_SHORE) continue;
 
@@ -1238,7 +1242,9 @@ void TileLoop_Water(TileIndex tile)
 
 				DoFloodTile(dest);
 			}
+			if (inert) tile_map.inert_tiles[tile] = true;
 			break;
+		}
 
 		case FLOOD_DRYUP: {
 			Slope slope_here = GetFoundationSlope(tile) & ~SLOPE_HALFTILE_MASK & ~SLOPE_STEEP;
@@ -1253,7 +1259,10 @@ void TileLoop_Water(TileIndex tile)
 			break;
 		}
 
-		default: return;
+		default:
+			/* Canals and rivers never flood. */
+			if (IsTileType(tile, MP_WATER)) tile_map.inert_tiles[tile] = true;
+			return;
 	}
 }
 
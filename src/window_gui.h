@@ -261,6 +261,9 @@ struct ViewportData : Viewport {
 	int32 scrollpos_y;        ///< Currently shown y coordinate (virtual screen coordinate of topleft corner of the viewport).
 	int32 dest_scrollpos_x;   ///< Current destination x coordinate to display (virtual screen coordinate of topleft corner of the viewport).
 	int32 dest_scrollpos_y;   ///< Current destination y coordinate to display (virtual screen coordinate of topleft corner of the viewport).
+	int32 prefetch_x;         ///< X coordinate of the centre of the area whose sprites were last prefetched (virtual screen coordinate).
+	int32 prefetch_y;         ///< Y coordinate of the centre of the area whose sprites were last prefetched (virtual screen coordinate).
+	ZoomLevel prefetch_zoom;  ///< Zoom level of the last prefetch, #ZOOM_LVL_END if nothing has been prefetched yet.
 };
 
 struct QueryString;